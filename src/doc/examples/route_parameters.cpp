@@ -0,0 +1,13 @@
+// router.map({QRegularExpression{"^/user/(?<name>[^/]+)/posts/(\\d+)$"},
+//             handler});
+
+bool Handler::handleRequest(HttpServerRequest &request,
+                            HttpServerResponse &response)
+{
+    const RouteParameters &parameters = request.routeParameters();
+
+    QStringRef name = parameters.value("name");
+    int post = parameters[1].toInt();
+
+    // ...
+}
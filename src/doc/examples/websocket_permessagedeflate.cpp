@@ -0,0 +1,25 @@
+bool RequestHandler::handleUpgrade(Tufao::HttpServerRequest &request,
+                                   const QByteArray &head)
+{
+    Tufao::WebSocket *socket = new Tufao::WebSocket(this);
+
+    // The JSON messages of this service compress well, but each connection
+    // keeps at most 4KiB of history to decompress the messages of the peer
+    socket->setPermessageDeflate(true);
+    socket->setPermessageDeflateMemoryLimit(4096);
+
+    if (!socket->startServerHandshake(request, head)) {
+        delete socket;
+        return true;
+    }
+
+    if (!socket->isPermessageDeflateActive())
+        qDebug("The client doesn't support permessage-deflate");
+
+    socket->setMessagesType(Tufao::WebSocketMessageType::TEXT_MESSAGE);
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    connect(socket, SIGNAL(newMessage(QByteArray)),
+            this, SLOT(onJsonRequest(QByteArray)));
+
+    return true;
+}
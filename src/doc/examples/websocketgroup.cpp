@@ -0,0 +1,20 @@
+// Tufao::WebSocketGroup chat; // shared by every connection
+
+bool RequestHandler::handleUpgrade(Tufao::HttpServerRequest &request,
+                                   const QByteArray &head)
+{
+    Tufao::WebSocket *socket = new Tufao::WebSocket;
+    socket->setPermessageDeflate(true);
+    if (!socket->startServerHandshake(request, head)) {
+        delete socket;
+        return true;
+    }
+
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    connect(socket, SIGNAL(newMessage(QByteArray)),
+            &chat, SLOT(broadcastUtf8Message(QByteArray)));
+
+    chat.add(socket);
+
+    return true;
+}
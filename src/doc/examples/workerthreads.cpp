@@ -0,0 +1,30 @@
+#include <QCoreApplication>
+#include <QThread>
+
+#include <Tufao/HttpServer>
+#include <Tufao/HttpServerRequest>
+#include <Tufao/HttpServerResponse>
+#include <Tufao/Headers>
+
+using namespace Tufao;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    HttpServer server;
+
+    // Called once inside each worker thread
+    server.setWorkerThreads(QThread::idealThreadCount(), []() {
+        return [](HttpServerRequest &, HttpServerResponse &response) -> bool {
+            response.writeHead(HttpResponseStatus::OK);
+            response.headers().replace("Content-Type", "text/plain");
+            response.end("Hello World\n");
+            return true;
+        };
+    });
+
+    server.listen(QHostAddress::Any, 8080);
+
+    return a.exec();
+}
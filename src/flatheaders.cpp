@@ -0,0 +1,273 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "flatheaders.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Tufao {
+
+static inline bool equalNames(const QByteArray &lhs, const QByteArray &rhs)
+{
+    return lhs.size() == rhs.size()
+        && caseInsensitiveEqual(lhs.constData(), rhs.constData(), lhs.size());
+}
+
+namespace {
+
+struct InternedName
+{
+    IByteArray name;
+    uint hash;
+};
+
+struct InternedNames
+{
+    InternedNames()
+    {
+        static const char *const names[] = {
+            "Accept",
+            "Accept-Charset",
+            "Accept-Encoding",
+            "Accept-Language",
+            "Accept-Ranges",
+            "Age",
+            "Allow",
+            "Authorization",
+            "Cache-Control",
+            "Connection",
+            "Content-Disposition",
+            "Content-Encoding",
+            "Content-Language",
+            "Content-Length",
+            "Content-Location",
+            "Content-Range",
+            "Content-Type",
+            "Cookie",
+            "DNT",
+            "Date",
+            "ETag",
+            "Expect",
+            "Expires",
+            "Forwarded",
+            "Host",
+            "If-Match",
+            "If-Modified-Since",
+            "If-None-Match",
+            "If-Range",
+            "If-Unmodified-Since",
+            "Keep-Alive",
+            "Last-Modified",
+            "Location",
+            "Origin",
+            "Pragma",
+            "Proxy-Authorization",
+            "Range",
+            "Referer",
+            "Sec-WebSocket-Accept",
+            "Sec-WebSocket-Extensions",
+            "Sec-WebSocket-Key",
+            "Sec-WebSocket-Protocol",
+            "Sec-WebSocket-Version",
+            "Server",
+            "Set-Cookie",
+            "TE",
+            "Trailer",
+            "Transfer-Encoding",
+            "Upgrade",
+            "Upgrade-Insecure-Requests",
+            "User-Agent",
+            "Vary",
+            "Via",
+            "WWW-Authenticate",
+            "X-Forwarded-For",
+            "X-Forwarded-Proto",
+            "X-Requested-With"
+        };
+
+        for (const char *name: names) {
+            const int size = int(std::strlen(name));
+            interned.append(InternedName{
+                                IByteArray(QByteArray::fromRawData(name, size)),
+                                FlatHeaders::hash(name, size)
+                            });
+        }
+    }
+
+    QVarLengthArray<InternedName, 64> interned;
+};
+
+static const IByteArray *findInterned(const char *data, int size)
+{
+    static const InternedNames names;
+    const uint hash = FlatHeaders::hash(data, size);
+
+    for (const auto &interned: names.interned) {
+        if (interned.hash == hash && interned.name.size() == size
+            && std::memcmp(interned.name.constData(), data, size) == 0) {
+            return &interned.name;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace
+
+FlatHeaders::FlatHeaders()
+{
+}
+
+FlatHeaders::FlatHeaders(const Headers &headers)
+{
+    entries.reserve(headers.size());
+
+    // QMultiHash iterates the values of a key from the most recent one
+    for (auto it = headers.begin();it != headers.end();) {
+        const int first = entries.size();
+        const IByteArray &name = it.key();
+
+        for (;it != headers.end() && it.key() == name;++it)
+            insert(name, it.value());
+
+        std::reverse(entries.begin() + first, entries.end());
+    }
+}
+
+Headers FlatHeaders::toHeaders() const
+{
+    Headers headers;
+
+    for (const auto &entry: entries)
+        headers.insert(entry.name, entry.value);
+
+    return headers;
+}
+
+void FlatHeaders::insert(const QByteArray &name, const QByteArray &value)
+{
+    entries.append(Entry{name, value, hash(name.constData(), name.size())});
+}
+
+void FlatHeaders::replace(const QByteArray &name, const QByteArray &value)
+{
+    const uint h = hash(name.constData(), name.size());
+    const int i = find(name, h, entries.size() - 1);
+
+    if (i == -1) {
+        entries.append(Entry{name, value, h});
+        return;
+    }
+
+    entries[i].value = value;
+}
+
+int FlatHeaders::remove(const QByteArray &name)
+{
+    const uint h = hash(name.constData(), name.size());
+    int kept = 0;
+
+    for (int i = 0;i != entries.size();++i) {
+        if (entries[i].hash == h && equalNames(entries[i].name, name))
+            continue;
+
+        if (kept != i)
+            entries[kept] = entries[i];
+        ++kept;
+    }
+
+    const int removed = entries.size() - kept;
+    entries.resize(kept);
+    return removed;
+}
+
+bool FlatHeaders::contains(const QByteArray &name) const
+{
+    return find(name, hash(name.constData(), name.size()),
+                entries.size() - 1) != -1;
+}
+
+int FlatHeaders::count(const QByteArray &name) const
+{
+    const uint h = hash(name.constData(), name.size());
+    int n = 0;
+
+    for (int i = find(name, h, entries.size() - 1);i != -1;
+         i = find(name, h, i - 1)) {
+        ++n;
+    }
+
+    return n;
+}
+
+QByteArray FlatHeaders::value(const QByteArray &name,
+                              const QByteArray &defaultValue) const
+{
+    const int i = find(name, hash(name.constData(), name.size()),
+                       entries.size() - 1);
+    return i == -1 ? defaultValue : entries[i].value;
+}
+
+QList<QByteArray> FlatHeaders::values(const QByteArray &name) const
+{
+    const uint h = hash(name.constData(), name.size());
+    QList<QByteArray> list;
+
+    for (int i = find(name, h, entries.size() - 1);i != -1;
+         i = find(name, h, i - 1)) {
+        list.push_back(entries[i].value);
+    }
+
+    return list;
+}
+
+IByteArray FlatHeaders::intern(const char *data, int size)
+{
+    if (const IByteArray *interned = findInterned(data, size))
+        return *interned;
+
+    return IByteArray(data, size);
+}
+
+IByteArray FlatHeaders::intern(const QByteArray &name)
+{
+    if (const IByteArray *interned = findInterned(name.constData(),
+                                                  name.size())) {
+        return *interned;
+    }
+
+    return name;
+}
+
+uint FlatHeaders::hash(const char *data, int size)
+{
+    return caseInsensitiveHash(data, size);
+}
+
+int FlatHeaders::find(const QByteArray &name, uint hash, int from) const
+{
+    for (int i = from;i >= 0;--i) {
+        if (entries[i].hash == hash && equalNames(entries[i].name, name))
+            return i;
+    }
+
+    return -1;
+}
+
+} // namespace Tufao
@@ -0,0 +1,205 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_FLATHEADERS_H
+#define TUFAO_FLATHEADERS_H
+
+#include <QtCore/QList>
+#include <QtCore/QVarLengthArray>
+
+#include "headers.h"
+
+namespace Tufao {
+
+/*!
+  This class provides a compact representation of HTTP headers.
+
+  Unlike Tufao::Headers, which allocates one hash node per header, the headers
+  are stored in insertion order in a contiguous array that holds up to 16
+  headers without allocating memory. The lookups are linear scans comparing
+  precomputed case-insensitive hashes of the names, which is faster than
+  hashing for the number of headers found in typical messages.
+
+  The names of well-known headers (e.g. "Host", "Content-Length", "Connection"
+  or "Cookie") are interned (see intern()), so storing them doesn't allocate
+  memory either.
+
+  The member functions follow the semantics of their Tufao::Headers
+  counterparts, and the conversion between the two classes is available for
+  code written against Tufao::Headers.
+
+  Tufao::HttpServerRequest parses the request headers into this container (see
+  Tufao::HttpServerRequest::flatHeaders) and only builds the Tufao::Headers
+  object when it's asked for.
+
+  \since
+  1.5
+  */
+class TUFAO_EXPORT FlatHeaders
+{
+public:
+    /*!
+      A header field.
+     */
+    struct Entry
+    {
+        IByteArray name;
+        QByteArray value;
+
+        /*!
+          The case-insensitive hash of name.
+         */
+        uint hash;
+    };
+
+    typedef const Entry *const_iterator;
+
+    /*!
+      Constructs an empty object.
+     */
+    FlatHeaders();
+
+    /*!
+      Constructs an object holding the same headers as \p headers.
+     */
+    FlatHeaders(const Headers &headers);
+
+    /*!
+      Returns a Tufao::Headers object holding the same headers.
+     */
+    Headers toHeaders() const;
+
+    /*!
+      Returns the number of headers.
+     */
+    int size() const;
+
+    /*!
+      Returns true if there are no headers.
+     */
+    bool isEmpty() const;
+
+    /*!
+      Removes all headers.
+     */
+    void clear();
+
+    /*!
+      Returns an iterator to the first header, in insertion order.
+     */
+    const_iterator begin() const;
+
+    /*!
+      Returns an iterator past the last header.
+     */
+    const_iterator end() const;
+
+    /*!
+      Adds a header. Headers with the same name are kept.
+     */
+    void insert(const QByteArray &name, const QByteArray &value);
+
+    /*!
+      Sets the value of the most recently inserted header named \p name to \p
+      value or adds a new header if there is no such header.
+     */
+    void replace(const QByteArray &name, const QByteArray &value);
+
+    /*!
+      Removes all headers named \p name.
+
+      \return
+      The number of removed headers.
+     */
+    int remove(const QByteArray &name);
+
+    /*!
+      Returns true if there is a header named \p name.
+     */
+    bool contains(const QByteArray &name) const;
+
+    /*!
+      Returns the number of headers named \p name.
+     */
+    int count(const QByteArray &name) const;
+
+    /*!
+      Returns the value of the most recently inserted header named \p name or
+      \p defaultValue if there is no such header.
+     */
+    QByteArray value(const QByteArray &name,
+                     const QByteArray &defaultValue = QByteArray()) const;
+
+    /*!
+      Returns the values of the headers named \p name, from the most recently
+      inserted to the least recently inserted one.
+     */
+    QList<QByteArray> values(const QByteArray &name) const;
+
+    /*!
+      Returns \p size bytes at \p data as a header name. If the bytes are
+      exactly the name of a well-known header, the returned object shares
+      static storage and no memory is allocated.
+     */
+    static IByteArray intern(const char *data, int size);
+
+    /*!
+      \overload
+     */
+    static IByteArray intern(const QByteArray &name);
+
+    /*!
+      Returns the case-insensitive hash of \p size bytes at \p data. Names
+      equal under IByteArray rules have the same hash.
+     */
+    static uint hash(const char *data, int size);
+
+private:
+    int find(const QByteArray &name, uint hash, int from) const;
+
+    QVarLengthArray<Entry, 16> entries;
+};
+
+inline int FlatHeaders::size() const
+{
+    return entries.size();
+}
+
+inline bool FlatHeaders::isEmpty() const
+{
+    return entries.isEmpty();
+}
+
+inline void FlatHeaders::clear()
+{
+    entries.clear();
+}
+
+inline FlatHeaders::const_iterator FlatHeaders::begin() const
+{
+    return entries.constData();
+}
+
+inline FlatHeaders::const_iterator FlatHeaders::end() const
+{
+    return entries.constData() + entries.size();
+}
+
+} // namespace Tufao
+
+#endif // TUFAO_FLATHEADERS_H
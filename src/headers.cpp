@@ -17,9 +17,7 @@
 */
 
 #include "headers.h"
-#include "priv/rfc1123.h"
-#include "priv/rfc1036.h"
-#include "priv/asctime.h"
+#include "priv/httpdate.h"
 
 #include <QtCore/QLocale>
 #include <QtCore/QDebug>
@@ -38,21 +36,9 @@ QByteArray Headers::fromDateTime(const QDateTime &dateTime)
 QDateTime Headers::toDateTime(const QByteArray &headerValue,
                               const QDateTime &defaultValue)
 {
-    {
-        Rfc1123 rfc1123(headerValue);
-        if (rfc1123)
-            return rfc1123();
-    }
-    {
-        Rfc1036 rfc1036(headerValue);
-        if (rfc1036)
-            return rfc1036();
-    }
-    {
-        Asctime asctime(headerValue);
-        if (asctime)
-            return asctime();
-    }
+    qint64 timestamp;
+    if (parseHttpDate(headerValue, timestamp))
+        return QDateTime::fromMSecsSinceEpoch(timestamp * 1000, Qt::UTC);
 
     return defaultValue;
 }
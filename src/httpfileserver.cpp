@@ -17,6 +17,10 @@
 */
 
 #include "priv/httpfileserver.h"
+#include "priv/httpdate.h"
+#include "priv/httpfilestreamer.h"
+#include "priv/httpfilecache.h"
+#include "priv/contentcoding.h"
 
 #include <QtCore/QFileInfo>
 #include <QtCore/QDateTime>
@@ -24,16 +28,27 @@
 #include <QtCore/QDir>
 #include <QtCore/QUrl>
 #include <QtCore/QMimeDatabase>
+#include <QtCore/QUuid>
 
 #include <QtNetwork/QAbstractSocket>
 
+#include <algorithm>
+#include <cstring>
+
 #include "httpserverrequest.h"
+#include "flatheaders.h"
 
 static qint64 bufferSize = BUFFER_SIZE;
+static qint64 streamWindow = 0;
+static bool servePrecompressed = false;
+
+// Requests with more ranges than this (after coalescing) get the entire entity
+static const int MAX_RANGES = 16;
 static const QMimeDatabase mimes;
+static Tufao::HttpFileCache cache;
 
 inline static QList< QPair<qulonglong, qulonglong> >
-ranges(const Tufao::Headers &headers, qulonglong fileSize)
+ranges(const Tufao::FlatHeaders &headers, qulonglong fileSize)
 {
     if (!headers.contains("Range"))
         return QList< QPair<qulonglong, qulonglong> >();
@@ -92,6 +107,166 @@ ranges(const Tufao::Headers &headers, qulonglong fileSize)
     return ranges;
 }
 
+// Returns true if any entity-tag in the If-Match or If-None-Match values
+// matches etag, which must be a strong entity-tag. The weak comparison ignores
+// the "W/" prefix, the strong one never matches weak entity-tags.
+inline static bool matchesETag(const QList<QByteArray> &values,
+                               const QByteArray &etag, bool weak)
+{
+    foreach (const QByteArray &value, values) {
+        const char *i = value.constData();
+        const char *end = i + value.size();
+
+        while (i != end) {
+            if (*i == ' ' || *i == '\t' || *i == ',') {
+                ++i;
+                continue;
+            }
+
+            if (*i == '*')
+                return true;
+
+            bool isWeak = false;
+            if (end - i > 1 && i[0] == 'W' && i[1] == '/') {
+                isWeak = true;
+                i += 2;
+            }
+
+            if (i == end || *i != '"')
+                break;
+
+            const char *tagEnd = static_cast<const char*>
+                (std::memchr(i + 1, '"', end - i - 1));
+            if (!tagEnd)
+                break;
+
+            ++tagEnd;
+            if ((weak || !isWeak) && tagEnd - i == etag.size()
+                && std::memcmp(i, etag.constData(), etag.size()) == 0) {
+                return true;
+            }
+
+            i = tagEnd;
+        }
+    }
+
+    return false;
+}
+
+// Precompressed siblings, in order of preference
+static const struct
+{
+    const char *coding;
+    const char *suffix;
+} precompressedEncodings[] = {
+    {"br", ".br"},
+    {"zstd", ".zst"},
+    {"gzip", ".gz"}
+};
+
+// Sorts the ranges and merges the overlapping and adjacent ones
+inline static QList< QPair<qulonglong, qulonglong> >
+coalesce(QList< QPair<qulonglong, qulonglong> > ranges)
+{
+    if (ranges.size() < 2)
+        return ranges;
+
+    std::sort(ranges.begin(), ranges.end());
+
+    QList< QPair<qulonglong, qulonglong> > coalesced;
+    coalesced.push_back(ranges[0]);
+
+    for (int i = 1;i != ranges.size();++i) {
+        QPair<qulonglong, qulonglong> &last(coalesced.back());
+        const QPair<qulonglong, qulonglong> &range(ranges[i]);
+
+        if (range.first <= last.second + 1)
+            last.second = qMax(last.second, range.second);
+        else
+            coalesced.push_back(range);
+    }
+
+    return coalesced;
+}
+
+// The head of a part of a multipart/byteranges body
+inline static QByteArray multipartHead(const QByteArray &boundary,
+                                       const QByteArray &contentType,
+                                       const QPair<qulonglong, qulonglong>
+                                       &range,
+                                       const QByteArray &size, bool first)
+{
+    static const char contentTypeKey[] = "Content-Type: ";
+    static const char contentRangeKey[] = "Content-Range: bytes ";
+
+    const QByteArray rangeFirst(QByteArray::number(range.first));
+    const QByteArray rangeLast(QByteArray::number(range.second));
+
+    QByteArray head;
+    head.reserve(4 + boundary.size() + 2
+                 + int(sizeof(contentTypeKey)) + contentType.size() + 2
+                 + int(sizeof(contentRangeKey)) + rangeFirst.size()
+                 + rangeLast.size() + size.size() + 6);
+
+    if (!first)
+        head.append("\r\n", 2);
+
+    head.append("--", 2);
+    head.append(boundary);
+    head.append("\r\n", 2);
+
+    if (!contentType.isEmpty()) {
+        head.append(contentTypeKey, sizeof(contentTypeKey) - 1);
+        head.append(contentType);
+        head.append("\r\n", 2);
+    }
+
+    head.append(contentRangeKey, sizeof(contentRangeKey) - 1);
+    head.append(rangeFirst);
+    head.append('-');
+    head.append(rangeLast);
+    head.append('/');
+    head.append(size);
+    head.append("\r\n\r\n", 4);
+
+    return head;
+}
+
+// Looks for a precompressed sibling of fileInfo (e.g. foo.js.br for foo.js)
+// that the client prefers over the file itself. The best one is stored in
+// sibling and its coding is returned. Returns an empty byte array if none is
+// found.
+inline static QByteArray
+precompressedSibling(const QFileInfo &fileInfo,
+                     const Tufao::FlatHeaders &headers, QFileInfo &sibling)
+{
+    const QList<QByteArray> acceptEncoding(headers.values("Accept-Encoding"));
+    if (acceptEncoding.isEmpty())
+        return QByteArray();
+
+    // identity is acceptable even when it isn't mentioned, but then (or when
+    // it only matches "*") it's not preferred over any coding
+    QByteArray coding;
+    int bestQuality = qMax(0, Tufao::acceptedQuality(acceptEncoding,
+                                                     "identity", false));
+
+    for (const auto &encoding: precompressedEncodings) {
+        int quality = Tufao::acceptedQuality(acceptEncoding, encoding.coding);
+        if (quality <= bestQuality)
+            continue;
+
+        QFileInfo candidate(fileInfo.filePath() + encoding.suffix);
+        if (!candidate.isFile())
+            continue;
+
+        bestQuality = quality;
+        coding = encoding.coding;
+        sibling = candidate;
+    }
+
+    return coding;
+}
+
 namespace Tufao {
 
 HttpFileServer::HttpFileServer(const QString &dir, QObject *parent) :
@@ -115,9 +290,9 @@ QString HttpFileServer::dir() const
     return priv->rootDir;
 }
 
-void HttpFileServer::serveFile(const QString &fileName,
-                               HttpServerRequest &request,
-                               HttpServerResponse &response)
+static void serveFileInfo(const QFileInfo &requestedFile,
+                          HttpServerRequest &request,
+                          HttpServerResponse &response)
 {
     // Check if method is alright
     {
@@ -130,79 +305,109 @@ void HttpFileServer::serveFile(const QString &fileName,
         }
     }
 
-    QFileInfo fileInfo(fileName);
-
-    if (!fileInfo.exists()) {
+    if (!requestedFile.exists()) {
         response.writeHead(HttpResponseStatus::NOT_FOUND);
         response.end();
         return;
     }
 
-    // Check "If-Modified-Since" header
-    if (request.headers().contains("If-Modified-Since")) {
-        foreach (const QByteArray &value,
-                 request.headers().values("If-Modified-Since")) {
-            QDateTime date(Headers::toDateTime(value));
+    const FlatHeaders &headers = request.flatHeaders();
 
-            // Ignore invalid values
-            if (fileInfo.lastModified() < date || !date.isValid()) {
-                continue;
-            } else if (fileInfo.lastModified() == date) {
-                response.writeHead(HttpResponseStatus::NOT_MODIFIED);
-                response.end();
-            }
-        }
+    // From now on, fileInfo refers to the representation being served
+    QFileInfo fileInfo(requestedFile);
+    QByteArray contentEncoding;
+
+    if (::servePrecompressed) {
+        contentEncoding = precompressedSibling(requestedFile, headers,
+                                               fileInfo);
+        response.headers().insert("Vary", "Accept-Encoding");
     }
 
-    // Check "If-Unmodified-Since" header
-    if (request.headers().contains("If-Unmodified-Since")) {
-        foreach (const QByteArray &value,
-                 request.headers().values("If-Unmodified-Since")) {
-            QDateTime date(Headers::toDateTime(value));
+    HttpFileCache::Entry cached;
+    const bool isCached = ::cache.get(fileInfo, cached);
 
-            // Ignore invalid values
-            if (fileInfo.lastModified() < date || !date.isValid()) {
-                continue;
-            } else if (fileInfo.lastModified() > date) {
-                response.writeHead(HttpResponseStatus::PRECONDITION_FAILED);
-                response.end();
-            }
+    const QByteArray etag(isCached ? cached.etag
+                          : fileETag(fileInfo.size(),
+                                     fileInfo.lastModified()));
+    const QByteArray lastModified(isCached ? cached.lastModified
+                                  : Headers::fromDateTime(fileInfo
+                                                          .lastModified()));
+
+    // HTTP-dates have a resolution of one second
+    const qint64 modificationTime
+        = fileInfo.lastModified().toMSecsSinceEpoch() / 1000;
+
+    // Conditionals are evaluated in the order given by RFC 7232's section 6
+    if (headers.contains("If-Match")) {
+        if (!matchesETag(headers.values("If-Match"), etag, false)) {
+            response.writeHead(HttpResponseStatus::PRECONDITION_FAILED);
+            response.end();
+            return;
+        }
+    } else if (headers.contains("If-Unmodified-Since")) {
+        qint64 date;
+        if (parseHttpDate(headers.value("If-Unmodified-Since"), date)
+            && modificationTime > date) {
+            response.writeHead(HttpResponseStatus::PRECONDITION_FAILED);
+            response.end();
+            return;
         }
     }
 
-    // Check If-Range header
-    if (request.headers().contains("If-Range")
-            && request.headers().contains("Range")) {
-        foreach (QByteArray value, request.headers().values("If-Range")) {
-            // Ignore ETags
-            int strSize = value.size();
-            if ((strSize > 0 && value[0] == '"')
-                    || (strSize > 1 && value[0] == 'W' && value[1] == '/')) {
-                continue;
-            } else {
-                QDateTime date(Headers::toDateTime(value));
+    bool notModified = false;
+    if (headers.contains("If-None-Match")) {
+        notModified = matchesETag(headers.values("If-None-Match"), etag, true);
+    } else if (headers.contains("If-Modified-Since")) {
+        qint64 date;
+        notModified = parseHttpDate(headers.value("If-Modified-Since"), date)
+            && modificationTime <= date;
+    }
 
-                // Ignore invalid values
-                if (fileInfo.lastModified() < date || !date.isValid()) {
-                    continue;
-                } else if (fileInfo.lastModified() > date) {
-                    // Return the entire entity using a 200 response
-                    request.headers().remove("Range");
-                    break;
-                }
-            }
+    if (notModified) {
+        response.writeHead(HttpResponseStatus::NOT_MODIFIED);
+        response.headers().insert("Date", currentHttpDate());
+        response.headers().insert("ETag", etag);
+        response.headers().insert("Last-Modified", lastModified);
+        response.end();
+        return;
+    }
+
+    // A failed If-Range means the entire entity is sent using a 200 response
+    bool ignoreRange = false;
+    if (headers.contains("If-Range") && headers.contains("Range")) {
+        const QByteArray value(headers.value("If-Range"));
+        bool fresh;
+
+        if (value.startsWith('"') || value.startsWith("W/")) {
+            fresh = matchesETag(QList<QByteArray>() << value, etag, false);
+        } else {
+            qint64 date;
+            fresh = parseHttpDate(value, date) && modificationTime == date;
         }
+
+        ignoreRange = !fresh;
     }
 
     // All conditionals were okay, continue...
 
     response.headers().insert("Accept-Ranges", "bytes");
-    response.headers().insert("Date", Headers
-                              ::fromDateTime(QDateTime::currentDateTime()));
-    response.headers().insert("Last-Modified", Headers
-                              ::fromDateTime(fileInfo.lastModified()));
+    response.headers().insert("Date", currentHttpDate());
+    response.headers().insert("ETag", etag);
+    response.headers().insert("Last-Modified", lastModified);
 
-    {
+    if (contentEncoding.size()) {
+        // The type is the one of the original file, not of its compressed form
+        response.headers().insert("Content-Encoding", contentEncoding);
+
+        QByteArray mime = mimes.mimeTypeForFile(requestedFile,
+                                                QMimeDatabase::MatchExtension)
+            .name().toUtf8();
+        if (mime.size())
+            response.headers().insert("Content-Type", mime);
+    } else if (isCached) {
+        if (cached.mimeType.size())
+            response.headers().insert("Content-Type", cached.mimeType);
+    } else {
         QByteArray mime = mimes.mimeTypeForFile(fileInfo).name().toUtf8();
         if (mime.size())
             response.headers().insert("Content-Type", mime);
@@ -214,16 +419,33 @@ void HttpFileServer::serveFile(const QString &fileName,
         return;
     }
 
-    QFile file(fileName);
-    file.open(QIODevice::ReadOnly);
+    HttpFileStreamer *streamer
+        = isCached
+        ? new HttpFileStreamer(cached.contents, response, &request.socket())
+        : new HttpFileStreamer(fileInfo.filePath(), response,
+                               &request.socket());
+    if (!streamer->open()) {
+        delete streamer;
+        response.writeHead(HttpResponseStatus::FORBIDDEN);
+        response.end();
+        return;
+    }
 
-    QList< QPair<qulonglong, qulonglong> >
-            ranges(::ranges(request.headers(), fileInfo.size()));
+    QList< QPair<qulonglong, qulonglong> > ranges;
+    if (!ignoreRange)
+        ranges = coalesce(::ranges(headers, fileInfo.size()));
+
+    // Many small ranges could be used to amplify the response, so the entire
+    // entity is sent instead
+    if (ranges.size() > MAX_RANGES) {
+        ranges.clear();
+        ignoreRange = true;
+    }
 
     // Not a byterange request
     if (!ranges.size()) {
         // Not a _satisfiable_ byterange request
-        if (request.headers().contains("Range")) {
+        if (!ignoreRange && headers.contains("Range")) {
             static const QByteArray bytesUnit("bytes */");
 
             response.writeHead(HttpResponseStatus
@@ -231,23 +453,22 @@ void HttpFileServer::serveFile(const QString &fileName,
             response.headers().insert("Content-Range", bytesUnit
                                       + QByteArray::number(fileInfo.size()));
             response.end();
+            delete streamer;
             return;
         }
 
         // Just send the entity
         response.writeHead(HttpResponseStatus::OK);
+        response.headers().insert("Content-Length",
+                                  QByteArray::number(fileInfo.size()));
 
-        while (!file.atEnd()) {
-            response << file.read(::bufferSize);
-            request.socket().flush();
-        }
-
-        response.end();
+        streamer->append(0, fileInfo.size());
+        streamer->start(::streamWindow);
     } else if (ranges.size() == 1) {
         // ONE range
         static const QByteArray bytesUnit("bytes ");
 
-        response.writeHead(HttpResponseStatus::OK);
+        response.writeHead(HttpResponseStatus::PARTIAL_CONTENT);
         QPair<qulonglong, qulonglong> &range(ranges[0]);
         response.headers().insert("Content-Range", bytesUnit
                                   + QByteArray::number(range.first)
@@ -255,71 +476,70 @@ void HttpFileServer::serveFile(const QString &fileName,
                                   + QByteArray::number(range.second)
                                   + '/'
                                   + QByteArray::number(fileInfo.size()));
-        file.seek(range.first);
-
-        qint64 remaining = 1 + range.second - range.first;
-        while (remaining) {
-            QByteArray chunk(file.read(qMin(remaining, ::bufferSize)));
-            response << chunk;
-            request.socket().flush();
-            remaining -= chunk.size();
+        response.headers().insert("Content-Length",
+                                  QByteArray::number(1 + range.second
+                                                     - range.first));
 
-            if (!request.socket().isOpen())
-                return;
-        }
-
-        response.end();
+        streamer->append(range.first, 1 + range.second - range.first);
+        streamer->start(::streamWindow);
     } else {
         // MULTIPLE ranges
-        QByteArray contentType(response.headers().value("Content-Type"));
+        const QByteArray boundary(QUuid::createUuid().toRfc4122().toHex());
+        const QByteArray contentType(response.headers().value("Content-Type"));
+        const QByteArray size(QByteArray::number(fileInfo.size()));
+
+        response.writeHead(HttpResponseStatus::PARTIAL_CONTENT);
         response.headers().replace("Content-Type", "multipart/byteranges;"
-                                   " boundary=THIS_STRING_SEPARATES");
+                                   " boundary=" + boundary);
+
+        // The CRLF that ends the data of each part belongs to the delimiter
+        // that follows it
+        QByteArray tail;
+        tail.reserve(boundary.size() + 8);
+        tail.append("\r\n--", 4);
+        tail.append(boundary);
+        tail.append("--\r\n", 4);
 
+        qint64 contentLength = tail.size();
         for (int i = 0;i != ranges.size();++i) {
-            QPair<qulonglong, qulonglong> &range(ranges[i]);
-            response << "--THIS_STRING_SEPARATES\r\n";
-            if (!contentType.isEmpty())
-                response << "Content-type: " << contentType << "\r\n";
-
-            response << QByteArray("Content-range: bytes")
-                     << QByteArray::number(range.first) << QByteArray(1, '-')
-                     << QByteArray::number(range.second)
-                     << QByteArray(1, '/')
-                     << QByteArray::number(fileInfo.size()) << "\r\n"
-                     << QByteArray("\r\n");
-
-            file.seek(range.first);
-
-            qint64 remaining = 1 + range.second - range.first;
-            while (remaining) {
-                QByteArray chunk(file.read(qMin(remaining, ::bufferSize)));
-                response << chunk;
-                request.socket().flush();
-                remaining -= chunk.size();
-            }
+            const QPair<qulonglong, qulonglong> &range(ranges[i]);
+            QByteArray partHead(multipartHead(boundary, contentType, range,
+                                              size, i == 0));
+
+            contentLength += partHead.size() + 1 + range.second - range.first;
+            streamer->append(partHead);
+            streamer->append(range.first, 1 + range.second - range.first);
         }
-        response.end("--THIS_STRING_SEPARATES--\r\n");
+
+        response.headers().insert("Content-Length",
+                                  QByteArray::number(contentLength));
+        streamer->start(::streamWindow, tail);
     }
 }
 
+void HttpFileServer::serveFile(const QString &fileName,
+                               HttpServerRequest &request,
+                               HttpServerResponse &response)
+{
+    serveFileInfo(QFileInfo(fileName), request, response);
+}
+
 bool HttpFileServer::serveFile(const QString &fileName,
                                HttpServerResponse &response,
                                HttpResponseStatus statusCode)
 {
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly))
+    HttpFileStreamer *streamer = new HttpFileStreamer(fileName, response, 0);
+    if (!streamer->open()) {
+        delete streamer;
         return false;
+    }
 
     response.writeHead(statusCode);
+    response.headers().insert("Content-Length",
+                              QByteArray::number(streamer->size()));
 
-    qint64 remaining = file.size();
-    while (remaining) {
-        QByteArray chunk(file.read(qMin(remaining, ::bufferSize)));
-        response << chunk;
-        response.flush();
-        remaining -= chunk.size();
-    }
-    response.end();
+    streamer->append(0, streamer->size());
+    streamer->start(0);
 
     return true;
 }
@@ -337,6 +557,55 @@ void HttpFileServer::setBufferSize(qint64 size)
     ::bufferSize = size;
 }
 
+bool HttpFileServer::servePrecompressed()
+{
+    return ::servePrecompressed;
+}
+
+void HttpFileServer::setServePrecompressed(bool enable)
+{
+    ::servePrecompressed = enable;
+}
+
+qint64 HttpFileServer::cacheSize()
+{
+    return ::cache.maxSize();
+}
+
+void HttpFileServer::setCacheSize(qint64 size)
+{
+    if (size < 0)
+        return;
+
+    ::cache.setMaxSize(size);
+}
+
+qint64 HttpFileServer::cacheMaxFileSize()
+{
+    return ::cache.maxFileSize();
+}
+
+void HttpFileServer::setCacheMaxFileSize(qint64 size)
+{
+    if (size < 0)
+        return;
+
+    ::cache.setMaxFileSize(size);
+}
+
+qint64 HttpFileServer::streamWindow()
+{
+    return ::streamWindow;
+}
+
+void HttpFileServer::setStreamWindow(qint64 size)
+{
+    if (size < 0)
+        return;
+
+    ::streamWindow = size;
+}
+
 std::function<bool(HttpServerRequest&, HttpServerResponse&)>
 HttpFileServer::handler(const QString &rootDir)
 {
@@ -389,11 +658,16 @@ inline bool HttpFileServer::handleRequest(HttpServerRequest &request,
                                           HttpServerResponse &response,
                                           const QString &rootDir)
 {
-    if (!canHandleRequest(request, rootDir))
+    QString fileName = filenameFromRequest(request, rootDir);
+    if (!fileName.startsWith(rootDir + "/"))
         return false;
 
-    QString fileName = filenameFromRequest(request, rootDir);
-    serveFile(fileName, request, response);
+    // The same QFileInfo (and stat call) is used to check and serve the file
+    QFileInfo fileInfo(fileName);
+    if (!fileInfo.isFile())
+        return false;
+
+    serveFileInfo(fileInfo, request, response);
     return true;
 }
 
@@ -47,9 +47,12 @@ namespace Tufao {
     - If-Range
     - Range
     - Content-Type through QMimeDatabase (_Since version 1.0_)
+    - ETag, If-Match and If-None-Match (_Since version 1.5_)
+
+  The entity tags are strong and derived from the size and the modification
+  time of the file.
 
   It won't handle:
-    - ETag (If-Match and If-None-Match headers)
     - Cache-Control response header: Useful for set cache max age
     - Content-Disposition response header
     - Content-MD5 response header
@@ -119,16 +122,148 @@ public:
       \note
       The buffer size is global to all HttpFileServer objects.
 
+      \note
+      Files are read in chunks of the buffer size and each chunk is queued in
+      the socket as is. When streaming (see setStreamWindow), the chunks are
+      also limited by the streaming window.
+
+      \note
+      The default value is given by the BUFFER_SIZE build option, which is 64KiB
+      since Tufão 1.5 (it used to be 128 bytes).
+
       \sa
       setBufferSize
       */
     static qint64 bufferSize();
 
     /*!
-      Set the buffer size.
+      Set the buffer size. Values smaller than 1 are ignored.
       */
     static void setBufferSize(qint64 size);
 
+    /*!
+      Returns the streaming window.
+
+      If the window is zero (the default), HttpFileServer::serveFile writes the
+      whole body before returning, as it always did.
+
+      Otherwise, files are streamed asynchronously: at most this number of
+      bytes is queued in the socket's write buffer and more data is sent as the
+      client consumes it. The request handler returns right away and other
+      connections are served while the transfer goes on. The response is
+      finished when the last byte is queued.
+
+      \note
+      The streaming window is global to all HttpFileServer objects.
+
+      \note
+      The response object must outlive the transfer. This is always true for
+      the responses created by HttpServer.
+
+      \sa
+      setStreamWindow
+
+      \since
+      1.5
+      */
+    static qint64 streamWindow();
+
+    /*!
+      Set the streaming window. Use zero to disable streaming.
+
+      \since
+      1.5
+      */
+    static void setStreamWindow(qint64 size);
+
+    /*!
+      Returns true if precompressed files are served.
+
+      When enabled, HttpFileServer looks for a sibling of the requested file
+      compressed ahead of time (e.g. "app.js.br", "app.js.zst" or "app.js.gz"
+      for "app.js") that the client accepts according to the Accept-Encoding
+      header. The sibling is served in place of the file, with the proper
+      Content-Encoding and the Content-Type of the original file. Range and
+      conditional requests apply to the chosen representation.
+
+      A sibling is only chosen if the client prefers its coding over
+      "identity". When many are acceptable, the coding with the highest
+      quality wins and ties are broken in the order br, zstd, gzip.
+
+      "Vary: Accept-Encoding" is added to every response while this is enabled.
+
+      It's disabled by default.
+
+      \note
+      This setting is global to all HttpFileServer objects.
+
+      \since
+      1.5
+      */
+    static bool servePrecompressed();
+
+    /*!
+      Enable or disable serving precompressed files.
+
+      \sa
+      servePrecompressed
+
+      \since
+      1.5
+      */
+    static void setServePrecompressed(bool enable);
+
+    /*!
+      Returns the maximum number of bytes used by the in-memory file cache.
+
+      Files up to HttpFileServer::cacheMaxFileSize bytes are kept in a LRU
+      cache together with their mime type and formatted modification date, so
+      hot files are served without touching the disk beyond a stat call. An
+      entry is reloaded when the size or the modification time of the file
+      changes.
+
+      The cache is disabled (zero) by default.
+
+      \note
+      The cache is global to all HttpFileServer objects and it's thread-safe.
+
+      \sa
+      setCacheSize
+
+      \since
+      1.5
+      */
+    static qint64 cacheSize();
+
+    /*!
+      Set the maximum number of bytes used by the in-memory file cache. Use
+      zero to disable the cache.
+
+      \since
+      1.5
+      */
+    static void setCacheSize(qint64 size);
+
+    /*!
+      Returns the size of the largest file that is cached in memory. The
+      default is 64 KiB.
+
+      \sa
+      cacheSize
+
+      \since
+      1.5
+      */
+    static qint64 cacheMaxFileSize();
+
+    /*!
+      Set the size of the largest file that is cached in memory.
+
+      \since
+      1.5
+      */
+    static void setCacheMaxFileSize(qint64 size);
+
     /*!
       Returns true iff HttpFileServer::handleRequest will return true.
 
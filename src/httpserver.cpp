@@ -17,8 +17,11 @@
 */
 
 #include "priv/httpserver.h"
+#include "priv/httpserverworker.h"
+#include <QtCore/QThread>
 #include <QtNetwork/QTcpSocket>
 #include "headers.h"
+#include "flatheaders.h"
 
 namespace Tufao {
 
@@ -32,12 +35,39 @@ HttpServer::HttpServer(QObject *parent) :
 
 HttpServer::~HttpServer()
 {
+    for (QThread *thread: priv->threads) {
+        thread->quit();
+        thread->wait();
+    }
+
     delete priv;
 }
 
 bool HttpServer::listen(const QHostAddress &address, quint16 port)
 {
-    return priv->tcpServer.listen(address, port);
+    if (!priv->tcpServer.listen(address, port))
+        return false;
+
+    if (priv->threads.size() || !priv->workerThreads)
+        return true;
+
+    priv->threads.reserve(priv->workerThreads);
+    priv->workers.reserve(priv->workerThreads);
+    for (int i = 0;i != priv->workerThreads;++i) {
+        QThread *thread = new QThread(this);
+        HttpServerWorker *worker = new HttpServerWorker(priv->handlerFactory,
+                                                        priv->timeout,
+                                                        priv->maxBodySize,
+                                                        priv->upgradeHandler);
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+
+        priv->threads.push_back(thread);
+        priv->workers.push_back(worker);
+    }
+
+    return true;
 }
 
 bool HttpServer::isListening() const
@@ -60,6 +90,16 @@ int HttpServer::timeout() const
     return priv->timeout;
 }
 
+void HttpServer::setMaxBodySize(qint64 size)
+{
+    priv->maxBodySize = qMax(size, qint64(0));
+}
+
+qint64 HttpServer::maxBodySize() const
+{
+    return priv->maxBodySize;
+}
+
 void HttpServer::setUpgradeHandler(HttpServer::UpgradeHandler functor)
 {
     if (!functor)
@@ -73,6 +113,20 @@ HttpServer::UpgradeHandler HttpServer::defaultUpgradeHandler()
     return Priv::defaultUpgradeHandler;
 }
 
+void HttpServer::setWorkerThreads(int threadsNumber, HandlerFactory factory)
+{
+    if (threadsNumber < 0 || !factory)
+        threadsNumber = 0;
+
+    priv->workerThreads = threadsNumber;
+    priv->handlerFactory = factory;
+}
+
+int HttpServer::workerThreads() const
+{
+    return priv->workerThreads;
+}
+
 void HttpServer::close()
 {
     priv->tcpServer.close();
@@ -99,12 +153,25 @@ void HttpServer::checkContinue(HttpServerRequest &request,
 
 void HttpServer::handleConnection(QAbstractSocket *socket)
 {
+    if (priv->workers.size()) {
+        HttpServerWorker *worker = priv->workers[priv->nextWorker];
+        priv->nextWorker = (priv->nextWorker + 1) % priv->workers.size();
+
+        socket->setParent(0);
+        socket->moveToThread(worker->thread());
+        worker->addConnection(socket);
+        return;
+    }
+
     socket->setParent(this);
     HttpServerRequest *handle = new HttpServerRequest(*socket, this);
 
     if (priv->timeout)
         handle->setTimeout(priv->timeout);
 
+    if (priv->maxBodySize)
+        handle->setMaxBodySize(priv->maxBodySize);
+
     connect(handle, &HttpServerRequest::ready,
             this, &HttpServer::onRequestReady);
     connect(handle, &HttpServerRequest::upgrade, this, &HttpServer::onUpgrade);
@@ -135,7 +202,7 @@ void HttpServer::onRequestReady()
     connect(response, &HttpServerResponse::finished,
             response, &QObject::deleteLater);
 
-    if (request->headers().contains("Expect", "100-continue"))
+    if (request->flatHeaders().values("Expect").contains("100-continue"))
         checkContinue(*request, *response);
     else
         emit requestReady(*request, *response);
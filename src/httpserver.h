@@ -68,6 +68,33 @@ public:
     typedef std::function<void(HttpServerRequest &request, const QByteArray&)>
         UpgradeHandler;
 
+    /*!
+      A typedef to the request handler used by worker threads.
+
+      It has the same signature of HttpServerRequestRouter::Handler, so you can
+      use any request handler (a router included) as the handler of a worker
+      thread.
+
+      \sa
+      setWorkerThreads
+
+      \since
+      1.5
+     */
+    typedef std::function<bool(HttpServerRequest&, HttpServerResponse&)>
+        Handler;
+
+    /*!
+      A typedef to the factory used to create one Handler per worker thread.
+
+      \sa
+      setWorkerThreads
+
+      \since
+      1.5
+     */
+    typedef std::function<Handler()> HandlerFactory;
+
     /*!
       Constructs a Tufao::HttpServer object.
 
@@ -131,6 +158,35 @@ public:
       */
     int timeout() const;
 
+    /*!
+      Sets the maximum size of the requests' body to \p size bytes.
+
+      Larger requests are rejected with a <em>413 Request Entity Too
+      Large</em> response.
+
+      If you set the maximum size to 0, then there is no limit.
+
+      By default, there is no limit.
+
+      \note
+      You should call this function before Tufao::HttpServer::listen.
+
+      \sa
+      Tufao::HttpServerRequest::setMaxBodySize
+
+      \since
+      1.5
+      */
+    void setMaxBodySize(qint64 size = 0);
+
+    /*!
+      Returns the current maximum size of the requests' body.
+
+      \since
+      1.5
+      */
+    qint64 maxBodySize() const;
+
     /*!
       This method sets the handler that will be called to handle http upgrade
       requests.
@@ -162,6 +218,63 @@ public:
      */
     static UpgradeHandler defaultUpgradeHandler();
 
+    /*!
+      Enables the multi-threaded mode, where connections are served by
+      \p threadsNumber worker threads, each one running its own event loop.
+
+      The listening thread only accepts connections. Each accepted connection
+      is handed off (round-robin) to one worker, which will own the
+      connection and its HttpServerRequest and HttpServerResponse objects
+      until the connection is closed. This way, a single event loop doesn't
+      cap the server throughput.
+
+      \p factory is called once inside each worker thread to create the
+      Handler used by that thread. Thus, handlers don't need to be
+      thread-safe, but \p factory itself must be.
+
+      \include workerthreads.cpp
+
+      If the handler returns false, a <em>404 Not Found</em> response is sent.
+
+      \note
+      You must call this function before Tufao::HttpServer::listen. The
+      timeout, the maximum body size and the upgrade handler are also copied
+      to the workers by Tufao::HttpServer::listen, so set them before as
+      well.
+
+      \note
+      In the multi-threaded mode, the Tufao::HttpServer::requestReady signal
+      and Tufao::HttpServer::checkContinue aren't used. Requests with the
+      "Expect: 100-continue" header are automatically answered with a
+      <em>100 Continue</em> response and the upgrade handler is called from
+      the worker thread.
+
+      \note
+      Connections are still created in the listening thread (see
+      Tufao::HttpServer::incomingConnection), so subclasses such as
+      Tufao::HttpsServer work in the multi-threaded mode too.
+
+      If \p threadsNumber is 0 or \p factory is empty, the multi-threaded mode
+      is disabled.
+
+      \sa
+      workerThreads
+
+      \since
+      1.5
+     */
+    void setWorkerThreads(int threadsNumber, HandlerFactory factory);
+
+    /*!
+      Returns the number of worker threads.
+
+      \retval 0 if the multi-threaded mode is disabled.
+
+      \since
+      1.5
+     */
+    int workerThreads() const;
+
 signals:
     /*!
       This signal is emitted each time there is request.
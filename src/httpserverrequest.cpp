@@ -17,9 +17,39 @@
 */
 
 #include "priv/httpserverrequest.h"
+#include "flatheaders.h"
+
+#include <QtCore/QStringList>
+
+#include <cstring>
 
 namespace Tufao {
 
+// The common methods are shared with static storage instead of being copied
+inline static QByteArray methodFromToken(const char *data, int size)
+{
+    static const char *const methods[] = {
+        "GET",
+        "HEAD",
+        "POST",
+        "PUT",
+        "DELETE",
+        "OPTIONS",
+        "PATCH",
+        "TRACE",
+        "CONNECT"
+    };
+
+    for (const char *method: methods) {
+        if (int(std::strlen(method)) == size
+            && std::memcmp(method, data, size) == 0) {
+            return QByteArray::fromRawData(method, size);
+        }
+    }
+
+    return QByteArray(data, size);
+}
+
 HttpServerRequest::HttpServerRequest(QAbstractSocket &socket, QObject *parent) :
     QObject(parent),
     priv(new Priv(socket))
@@ -54,12 +84,17 @@ QUrl HttpServerRequest::url() const
 
 Headers HttpServerRequest::headers() const
 {
-    return priv->headers;
+    return priv->builtHeaders();
 }
 
 Headers &HttpServerRequest::headers()
 {
-    return priv->headers;
+    return priv->builtHeaders();
+}
+
+const FlatHeaders &HttpServerRequest::flatHeaders() const
+{
+    return priv->flatHeaders;
 }
 
 Headers HttpServerRequest::trailers() const
@@ -76,6 +111,18 @@ QByteArray HttpServerRequest::readBody()
 {
     QByteArray body;
     body.swap(priv->body);
+    resumeBody();
+    return body;
+}
+
+QByteArray HttpServerRequest::readBody(qint64 maxSize)
+{
+    if (maxSize >= priv->body.size())
+        return readBody();
+
+    QByteArray body = priv->body.left(int(qMax(maxSize, qint64(0))));
+    priv->body.remove(0, body.size());
+    resumeBody();
     return body;
 }
 
@@ -99,6 +146,47 @@ int HttpServerRequest::timeout() const
     return priv->timeout;
 }
 
+void HttpServerRequest::setMaxBodySize(qint64 size)
+{
+    priv->maxBodySize = qMax(size, qint64(0));
+}
+
+qint64 HttpServerRequest::maxBodySize() const
+{
+    return priv->maxBodySize;
+}
+
+void HttpServerRequest::setBodyWatermarks(qint64 highWatermark,
+                                          qint64 lowWatermark)
+{
+    if (highWatermark <= 0) {
+        priv->highWatermark = 0;
+        priv->lowWatermark = 0;
+        priv->socket.setReadBufferSize(0);
+
+        if (priv->paused) {
+            priv->paused = false;
+            QMetaObject::invokeMethod(this, "onReadyRead",
+                                      Qt::QueuedConnection);
+        }
+        return;
+    }
+
+    priv->highWatermark = highWatermark;
+    priv->lowWatermark = qBound(qint64(0), lowWatermark, highWatermark);
+    priv->socket.setReadBufferSize(highWatermark);
+}
+
+qint64 HttpServerRequest::bodyHighWatermark() const
+{
+    return priv->highWatermark;
+}
+
+qint64 HttpServerRequest::bodyLowWatermark() const
+{
+    return priv->lowWatermark;
+}
+
 HttpServerResponse::Options HttpServerRequest::responseOptions() const
 {
     return priv->responseOptions;
@@ -106,33 +194,65 @@ HttpServerResponse::Options HttpServerRequest::responseOptions() const
 
 QVariant HttpServerRequest::customData() const
 {
-    return priv->customData;
+    const RouteParameters &parameters = priv->routeParameters;
+    const int merged = qMin(priv->customDataArgs, parameters.size());
+
+    if (merged == parameters.size())
+        return priv->customData;
+
+    // The routers used to store the captures in the "args" item
+    QVariantMap options{priv->customData.toMap()};
+    QStringList args{options["args"].toStringList()};
+
+    for (int i = merged;i != parameters.size();++i)
+        args.push_back(parameters[i].toString());
+
+    options["args"] = args;
+    return options;
 }
 
 void HttpServerRequest::setCustomData(const QVariant &data)
 {
     priv->customData = data;
+    priv->customDataArgs = priv->routeParameters.size();
+}
+
+const RouteParameters &HttpServerRequest::routeParameters() const
+{
+    return priv->routeParameters;
+}
+
+RouteParameters &HttpServerRequest::routeParameters()
+{
+    return priv->routeParameters;
 }
 
 void HttpServerRequest::resume()
 {
     connect(&priv->socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
 
-    if (priv->buffer.size())
+    if (priv->buffer.size() - priv->bufferOffset)
         onReadyRead();
 }
 
 void HttpServerRequest::onReadyRead()
 {
+    // Keep the data in the socket and let the TCP flow control do its job
+    if (priv->paused)
+        return;
+
     if (priv->timeout)
         priv->timer.start(priv->timeout);
 
-    priv->buffer += priv->socket.readAll();
-    priv->parser.set_buffer(asio::buffer(priv->buffer.data(),
-                                         priv->buffer.size()));
+    fillBuffer();
+    priv->parser.set_buffer(asio::buffer(priv->buffer.data()
+                                         + priv->bufferOffset,
+                                         priv->buffer.size()
+                                         - priv->bufferOffset));
 
     Priv::Signals whatEmit(0);
     bool is_upgrade = false;
+    bool pause = false;
 
     while(priv->parser.code() != http::token::code::error_insufficient_data) {
         switch(priv->parser.symbol()) {
@@ -146,8 +266,7 @@ void HttpServerRequest::onReadyRead()
                 clearRequest();
                 priv->responseOptions = 0;
                 auto value = priv->parser.value<http::token::method>();
-                QByteArray method(value.data(), value.size());
-                priv->method = std::move(method);
+                priv->method = methodFromToken(value.data(), value.size());
             }
             break;
         case http::token::symbol::request_target:
@@ -179,14 +298,16 @@ void HttpServerRequest::onReadyRead()
         case http::token::symbol::trailer_name:
             {
                 auto value = priv->parser.value<http::token::field_name>();
-                priv->lastHeader = QByteArray(value.data(), value.size());
+                // Well-known names share static storage
+                priv->lastHeader = FlatHeaders::intern(value.data(),
+                                                       value.size());
             }
             break;
         case http::token::symbol::field_value:
             {
                 auto value = priv->parser.value<http::token::field_value>();
                 QByteArray header(value.data(), value.size());
-                priv->headers.insert(priv->lastHeader, std::move(header));
+                priv->flatHeaders.insert(priv->lastHeader, header);
                 priv->lastHeader.clear();
             }
             break;
@@ -200,11 +321,18 @@ void HttpServerRequest::onReadyRead()
             break;
         case http::token::symbol::end_of_headers:
             {
-                auto it = priv->headers.find("connection");
+                static const char connectionKey[] = "Connection";
+                const IByteArray connection(QByteArray::fromRawData
+                                            (connectionKey,
+                                             sizeof(connectionKey) - 1));
                 bool close_found = false;
                 bool keep_alive_found = false;
-                for (;it != priv->headers.end();++it) {
-                    auto value = boost::string_view(it->data(), it->size());
+                for (const FlatHeaders::Entry &entry: priv->flatHeaders) {
+                    if (entry.name != connection)
+                        continue;
+
+                    auto value = boost::string_view(entry.value.data(),
+                                                    entry.value.size());
                     http::header_value_any_of(value, [&](boost::string_view v) {
                         if (iequals(v, "close"))
                             close_found = true;
@@ -225,22 +353,48 @@ void HttpServerRequest::onReadyRead()
                         || keep_alive_found)) {
                     priv->responseOptions |= HttpServerResponse::KEEP_ALIVE;
                 }
+
+                if (priv->maxBodySize && !is_upgrade) {
+                    static const char key[] = "Content-Length";
+                    QByteArray length(priv->flatHeaders
+                                      .value(QByteArray::fromRawData
+                                             (key, sizeof(key) - 1)));
+                    if (!length.isNull()
+                        && length.toULongLong() > quint64(priv->maxBodySize)) {
+                        rejectBody(true);
+                        return;
+                    }
+                }
+
                 whatEmit = Priv::READY;
             }
             break;
         case http::token::symbol::body_chunk:
             {
                 auto value = priv->parser.value<http::token::body_chunk>();
+                priv->bodySize += asio::buffer_size(value);
+
+                if (priv->maxBodySize && priv->bodySize > priv->maxBodySize) {
+                    rejectBody(whatEmit.testFlag(Priv::READY));
+                    return;
+                }
+
                 priv->body.append(asio::buffer_cast<const char*>(value),
                                   asio::buffer_size(value));
                 whatEmit |= Priv::DATA;
+
+                if (priv->highWatermark
+                    && priv->body.size() >= priv->highWatermark) {
+                    pause = true;
+                }
             }
             break;
         case http::token::symbol::end_of_body:
             break;
         case http::token::symbol::end_of_message:
-            priv->buffer.remove(0, priv->parser.parsed_count());
-            priv->parser.set_buffer(asio::buffer(priv->buffer.data(),
+            priv->bufferOffset += priv->parser.parsed_count();
+            priv->parser.set_buffer(asio::buffer(priv->buffer.data()
+                                                 + priv->bufferOffset,
                                                  priv->parser.token_size()));
             whatEmit |= Priv::END;
             disconnect(&priv->socket, SIGNAL(readyRead()),
@@ -249,8 +403,13 @@ void HttpServerRequest::onReadyRead()
         }
 
         priv->parser.next();
+
+        if (pause) {
+            priv->paused = true;
+            break;
+        }
     }
-    priv->buffer.remove(0, priv->parser.parsed_count());
+    priv->bufferOffset += priv->parser.parsed_count();
 
     if (is_upgrade) {
         disconnect(&priv->socket, SIGNAL(readyRead()),
@@ -259,7 +418,9 @@ void HttpServerRequest::onReadyRead()
                    this, SIGNAL(close()));
         disconnect(&priv->timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
 
-        priv->body.swap(priv->buffer);
+        priv->body = priv->buffer.mid(priv->bufferOffset);
+        priv->buffer.clear();
+        priv->bufferOffset = 0;
         emit upgrade();
         return;
     }
@@ -288,14 +449,69 @@ void HttpServerRequest::onTimeout()
     priv->socket.close();
 }
 
+inline void HttpServerRequest::fillBuffer()
+{
+    int unparsed = priv->buffer.size() - priv->bufferOffset;
+
+    // Discard the consumed bytes only when it's cheap (nothing to move) or
+    // when they're the majority of the buffer, amortizing the memmove
+    if (priv->bufferOffset
+        && (unparsed == 0 || priv->bufferOffset >= unparsed)) {
+        priv->buffer.remove(0, priv->bufferOffset);
+        priv->bufferOffset = 0;
+    }
+
+    qint64 available = priv->socket.bytesAvailable();
+    if (available <= 0)
+        return;
+
+    // Read straight into the buffer's spare room
+    int size = priv->buffer.size();
+    priv->buffer.resize(size + int(available));
+    qint64 read = priv->socket.read(priv->buffer.data() + size, available);
+    priv->buffer.resize(size + int(qMax(read, qint64(0))));
+}
+
 inline void HttpServerRequest::clearRequest()
 {
     priv->method.clear();
     priv->url.clear();
+    priv->flatHeaders.clear();
     priv->headers.clear();
+    priv->headersBuilt = false;
     priv->body.clear();
+    priv->bodySize = 0;
     priv->trailers.clear();
     priv->customData.clear();
+    priv->customDataArgs = 0;
+    priv->routeParameters.clear();
+}
+
+inline void HttpServerRequest::resumeBody()
+{
+    // Only the body that remains buffered is compared against the watermark
+    if (!priv->paused || priv->body.size() > priv->lowWatermark)
+        return;
+
+    priv->paused = false;
+    // readBody is usually called from a slot connected to the data signal, so
+    // we can't parse the buffer right now
+    QMetaObject::invokeMethod(this, "onReadyRead", Qt::QueuedConnection);
+}
+
+inline void HttpServerRequest::rejectBody(bool respond)
+{
+    disconnect(&priv->socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+
+    if (respond) {
+        HttpServerResponse response(priv->socket,
+                                    priv->responseOptions
+                                    & ~HttpServerResponse::KEEP_ALIVE);
+        response.writeHead(HttpResponseStatus::REQUEST_ENTITY_TOO_LARGE);
+        response.end();
+    } else {
+        priv->socket.close();
+    }
 }
 
 } // namespace Tufao
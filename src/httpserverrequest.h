@@ -31,6 +31,8 @@ class QUrl;
 namespace Tufao {
 
 struct Headers;
+class FlatHeaders;
+class RouteParameters;
 
 enum class HttpVersion
 {
@@ -140,6 +142,12 @@ public:
       The HTTP headers sent by the client. These headers are fully populated
       when the signal Tufao::HttpServerRequest::ready signal is emitted.
 
+      \note
+      Since Tufão 1.5, the headers are parsed into a Tufao::FlatHeaders object
+      and this Tufao::Headers object is only built on the first call to one of
+      the headers() overloads for each request. Prefer
+      Tufao::HttpServerRequest::flatHeaders if you only need to read them.
+
       \sa
       Tufao::HttpServerRequest::trailers()
       */
@@ -157,6 +165,23 @@ public:
       */
     Headers &headers();
 
+    /*!
+      The HTTP headers sent by the client, as they were received.
+
+      The headers are stored in this container when the request is parsed, so
+      reading them doesn't build the Tufao::Headers object returned by
+      Tufao::HttpServerRequest::headers.
+
+      \note
+      Changes made through Tufao::HttpServerRequest::headers aren't reflected
+      in this object. Tufao::HttpFileServer and
+      Tufao::WebSocket::startServerHandshake read the headers from here.
+
+      \since
+      1.5
+      */
+    const FlatHeaders &flatHeaders() const;
+
     /*!
       The HTTP trailers (if present). Only populated after the
       Tufao::HttpServerRequest::end signal.
@@ -186,15 +211,37 @@ public:
       signal is emitted and save the body to disk if you expect to receive
       requests with bodies larger than available RAM.
 
+      \note
+      In the streaming body mode, calling this function may resume the reading
+      of the socket.
+
       \sa
       data()
       end()
+      setBodyWatermarks
 
       \since
       1.0
      */
     QByteArray readBody();
 
+    /*!
+      Reads at most \p maxSize bytes of the request's body.
+
+      The returned bytes are removed from the front of the buffered body and
+      the remaining bytes are kept for the next calls. It's useful in the
+      streaming body mode, where the reading of the socket is only resumed
+      once the remaining buffered body is at most the low watermark.
+
+      \sa
+      readBody()
+      setBodyWatermarks
+
+      \since
+      1.5
+     */
+    QByteArray readBody(qint64 maxSize);
+
     /*!
       The QAbstractSocket object associated with the connection.
 
@@ -225,6 +272,86 @@ public:
       */
     int timeout() const;
 
+    /*!
+      Sets the maximum size of the request's body to \p size bytes.
+
+      Requests whose Content-Length header exceeds \p size are rejected with a
+      <em>413 Request Entity Too Large</em> response before any byte of the
+      body is buffered. Bodies without a declared length (chunked messages)
+      are rejected as soon as they grow beyond \p size. If the
+      Tufao::HttpServerRequest::ready signal was already emitted by then, the
+      connection is just closed, because the handler might have started the
+      response already.
+
+      If you set the maximum size to 0, then there is no limit.
+
+      By default, there is no limit.
+
+      \note
+      The limit is kept for the remaining requests of the connection.
+
+      \since
+      1.5
+      */
+    void setMaxBodySize(qint64 size = 0);
+
+    /*!
+      Returns the current maximum size of the request's body.
+
+      \since
+      1.5
+      */
+    qint64 maxBodySize() const;
+
+    /*!
+      Enables the streaming body mode, where the amount of body kept in memory
+      is bounded.
+
+      Body chunks are still delivered as they arrive through the
+      Tufao::HttpServerRequest::data signal, but if the buffered body (the
+      data not consumed yet through Tufao::HttpServerRequest::readBody) reaches
+      \p highWatermark bytes, the object stops reading from the socket. The
+      reading is resumed once Tufao::HttpServerRequest::readBody is called and
+      the buffered body is at most \p lowWatermark bytes. Meanwhile, the
+      socket's read buffer is limited too, so the TCP flow control will slow
+      down the client.
+
+      If you set \p highWatermark to 0, the streaming body mode is disabled.
+
+      By default, the streaming body mode is disabled.
+
+      \note
+      In the streaming body mode, you must consume the body (call
+      Tufao::HttpServerRequest::readBody) even if you don't need it, or the
+      connection won't progress to the next request.
+
+      \note
+      The watermarks are kept for the remaining requests of the connection.
+
+      \sa
+      readBody
+
+      \since
+      1.5
+      */
+    void setBodyWatermarks(qint64 highWatermark, qint64 lowWatermark = 0);
+
+    /*!
+      Returns the high watermark set in setBodyWatermarks.
+
+      \since
+      1.5
+      */
+    qint64 bodyHighWatermark() const;
+
+    /*!
+      Returns the low watermark set in setBodyWatermarks.
+
+      \since
+      1.5
+      */
+    qint64 bodyLowWatermark() const;
+
     /*!
       Returns the options obje that should be passed to the
       Tufao::HttpServerResponse constructor.
@@ -236,6 +363,11 @@ public:
     /*!
       Returns the user data as set in setCustomData.
 
+      For compatibility, if the routers captured texts that weren't present
+      when setCustomData was called, they are appended to the "args" item of
+      the returned QVariantMap, as the routers used to do. This conversion
+      allocates memory, so new code should use routeParameters instead.
+
       \note
       This data will be erased upon a new request.
 
@@ -250,9 +382,7 @@ public:
       Sets the custom data to \p data.
 
       The custom data is a convenience method to allow users of
-      HttpServerRequest to store some data in some requests. It's used in
-      Tufao::HttpServerRequestRouter to pass the list of captured texts in the
-      url to the subsequent handlers.
+      HttpServerRequest to store some data in some requests.
 
       \note
       This data will be erased upon a new request.
@@ -261,6 +391,28 @@ public:
      */
     void setCustomData(const QVariant &data);
 
+    /*!
+      Returns the texts captured by Tufao::HttpServerRequestRouter and
+      Tufao::HttpUpgradeRouter from the url.
+
+      \note
+      The parameters will be erased upon a new request.
+
+      \since
+      1.5
+     */
+    const RouteParameters &routeParameters() const;
+
+    /*!
+      \overload
+
+      The routers use this overload to add their captures.
+
+      \since
+      1.5
+     */
+    RouteParameters &routeParameters();
+
 public slots:
     /*!
       This function exists to support HTTP pipelining.
@@ -361,7 +513,10 @@ private slots:
 
 private:
     void clearBuffer();
+    void fillBuffer();
     void clearRequest();
+    void resumeBody();
+    void rejectBody(bool respond);
 
     struct Priv;
     Priv *priv;
@@ -18,10 +18,9 @@
 
 #include "priv/httpserverrequestrouter.h"
 #include "httpserverrequest.h"
+#include "routeparameters.h"
 
-#include <QtCore/QStringList>
 #include <QtCore/QUrl>
-#include <QtCore/QVariant>
 
 #include <algorithm>
 
@@ -51,6 +50,7 @@ int HttpServerRequestRouter::map(Mapping map)
 {
     int i = priv->mappings.size();
     priv->mappings.push_back(map);
+    priv->dirty = true;
     return i;
 }
 
@@ -59,50 +59,114 @@ int HttpServerRequestRouter::map(std::initializer_list<Mapping> map)
     int i = priv->mappings.size();
     std::copy(std::begin(map), std::end(map),
               std::back_inserter(priv->mappings));
+    priv->dirty = true;
     return i;
 }
 
 void HttpServerRequestRouter::unmap(int index)
 {
     priv->mappings.remove(index);
+    priv->dirty = true;
 }
 
 void HttpServerRequestRouter::clear()
 {
     priv->mappings.clear();
+    priv->dirty = true;
+}
+
+void HttpServerRequestRouter::setCacheSize(int entries)
+{
+    priv->cache.setMaxCost(entries);
+}
+
+int HttpServerRequestRouter::cacheSize() const
+{
+    return priv->cache.maxCost();
 }
 
-// TODO: Implement cache and use a tree to improve speed
 bool HttpServerRequestRouter::handleRequest(HttpServerRequest &request,
                                             HttpServerResponse &response)
 {
+    if (priv->dirty)
+        priv->update();
+
     const QString path{request.url().path()};
+    const Priv::Matches matches{priv->lookup(request.method(), path)};
 
-    for (const auto &mapping: priv->mappings) {
-        QRegularExpressionMatch match{mapping.path.match(path)};
+    if (matches.isEmpty())
+        return false;
 
-        if (match.hasMatch()) {
-            if (mapping.method.size() && request.method() != mapping.method)
-                continue;
+    RouteParameters &parameters = request.routeParameters();
+    const int previous = parameters.size();
 
-            QStringList args{match.capturedTexts().mid(1)};
-            QVariant backup{request.customData()};
+    // A declining handler must not leak its custom data to the next ones
+    const QVariant backup{request.customData()};
 
-            if (args.size()) {
-                QVariantMap options{backup.toMap()};
-                options["args"] = options["args"].toStringList() + args;
-                request.setCustomData(options);
-            }
+    for (const auto &match: matches) {
+        const Mapping &mapping = priv->mappings[match.index];
+        appendRouteParameters(parameters, path, match.captures,
+                              priv->captureNames[match.index]);
 
-            if (mapping.handler(request, response))
-                return true;
+        if (mapping.handler(request, response))
+            return true;
 
-            if (args.size())
-                request.setCustomData(backup);
-        }
+        parameters.truncate(previous);
+        request.setCustomData(backup);
     }
 
     return false;
 }
 
+void HttpServerRequestRouter::Priv::update()
+{
+    buckets.clear();
+    anyMethod.clear();
+    cache.clear();
+
+    captureNames.clear();
+    captureNames.reserve(mappings.size());
+    for (const auto &mapping: mappings)
+        captureNames.push_back(mapping.path.namedCaptureGroups());
+
+    for (const auto &mapping: mappings) {
+        if (mapping.method.size())
+            buckets[mapping.method];
+    }
+
+    for (int i = 0;i != mappings.size();++i) {
+        if (mappings[i].method.size()) {
+            buckets[mappings[i].method].insert(mappings[i].path, i);
+            continue;
+        }
+
+        anyMethod.insert(mappings[i].path, i);
+        for (auto &bucket: buckets)
+            bucket.insert(mappings[i].path, i);
+    }
+
+    dirty = false;
+}
+
+HttpServerRequestRouter::Priv::Matches
+HttpServerRequestRouter::Priv::lookup(const QByteArray &method,
+                                      const QString &path)
+{
+    const CacheKey key{method, path};
+
+    if (const Matches *cached = cache.object(key))
+        return *cached;
+
+    auto it = buckets.constFind(method);
+    const RouteTable &routes = it != buckets.constEnd() ? *it : anyMethod;
+
+    Matches matches;
+    routes.match(path, matches);
+
+    if (cache.maxCost() > 0)
+        cache.insert(key, new Matches(matches));
+
+    return matches;
+}
+
 } // namespace Tufao
@@ -41,7 +41,15 @@ namespace Tufao {
 
   The type of mapping rules used in this class provides a predictable behaviour
   that is simple to understand and allow the use of caching algorithms to
-  improve the performance.
+  improve the performance. Simple patterns (a '^' anchor followed by literal
+  text, captures of whole path segments like "([^/]+)", "(\\w+)" or "(\\d+)",
+  an optional "(.*)" capture of the rest of the path and an optional '$'
+  anchor) are compiled into a tree, so the cost to find these handlers doesn't
+  grow with the number of mappings. The remaining patterns are matched using
+  the regular expressions, in the same order. The mappings are grouped by HTTP
+  method, so mappings restricted to other methods are never evaluated, and the
+  result of the matching is cached for the most requested paths (see
+  setCacheSize).
 
   When the router finds one matching request handler, it will call it passing
   the request and response objects. If the found handler cannot handle the
@@ -182,34 +190,61 @@ public:
       */
     void clear();
 
+    /*!
+      Sets the maximum number of (method, path) pairs whose matching mappings
+      are remembered by the router to \p entries. Requests for a remembered
+      pair skip the matching entirely. The least recently used pairs are
+      forgotten first and any change in the mappings forgets all of them.
+
+      A value of 0 disables the cache. The default value is 1024.
+
+      \since
+      1.5
+     */
+    void setCacheSize(int entries);
+
+    /*!
+      Returns the maximum number of (method, path) pairs remembered by the
+      router.
+
+      \sa
+      setCacheSize
+
+      \since
+      1.5
+     */
+    int cacheSize() const;
+
 public slots:
     /*!
       It will route the request to the right handler.
 
       The handler will have access to the list of captured texts by the regular
-      expression using HttpServerRequest::customData.
-
-      \note
-      The router won't touch the HttpServerRequest::customData if the regex
-      don't capture any text.
+      expression using HttpServerRequest::routeParameters. The captures are
+      appended before the handler is called and removed if it declines the
+      request, along with any change it made to HttpServerRequest::customData.
+      Named capture groups can also be accessed by name.
 
       See example below:
 
+      \include route_parameters.cpp
+
+      \note
+      For compatibility, the captured texts are also available in the "args"
+      item of HttpServerRequest::customData:
+
       \include custom_data.cpp
 
-      If there is already an object set for this request, the router will do the
-      following steps:
+      \note
+      This router doesn't store the captures in the custom data anymore. The
+      "args" item is filled by HttpServerRequest::customData from the route
+      parameters, using the following steps:
 
       1. If the object is not a QVariantMap, override it
       2. If the object already has a item with the key "args", but the value is
          not a QStringList, override the item
       3. Append the list of captured texts in the object["args"]
 
-      \note
-      The request's custom data is copied at the beginning and is used to
-      restore the custom data state before call every handler. The state will
-      also be restored if no handlers are capable of handle the request.
-
       \return
       Returns true if one handler able to respond the request is found.
 
@@ -18,6 +18,8 @@
 
 #include "priv/httpserverresponse.h"
 #include "priv/reasonphrase.h"
+#include "priv/httpdate.h"
+#include "priv/contentcoding.h"
 
 #include <QtNetwork/QAbstractSocket>
 
@@ -27,8 +29,182 @@ static const char crlf[] = "\r\n";
 static const char lastChunk[] = "0\r\n";
 #define LAST_CHUNK lastChunk, sizeof(lastChunk) - 1
 
+// CRLF that ends the last data chunk, the last chunk and the empty trailer
+static const char chunkedTail[] = "\r\n0\r\n\r\n";
+#define CHUNKED_TAIL chunkedTail, sizeof(chunkedTail) - 1
+
+// Hex digits of an int plus CRLF
+static const int CHUNK_SIZE_LINE_MAX = int(sizeof(int)) * 2 + 2;
+
+// Bodies smaller than this aren't worth compressing and bodies larger than
+// COMPRESSION_WINDOW aren't buffered to be compressed
+static const int COMPRESSION_MIN_SIZE = 1024;
+static const int COMPRESSION_WINDOW = 1 << 20;
+
 namespace Tufao {
 
+inline static void appendStatusLine(QByteArray &buffer,
+                                    HttpServerResponse::Options options,
+                                    int statusCode,
+                                    const QByteArray &reasonPhrase)
+{
+    buffer.reserve(buffer.size() + 15 + reasonPhrase.size());
+
+    if (options.testFlag(HttpServerResponse::HTTP_1_0)) {
+        static const char chunk[] = "HTTP/1.0 ";
+        buffer.append(chunk, sizeof(chunk) - 1);
+    } else {
+        static const char chunk[] = "HTTP/1.1 ";
+        buffer.append(chunk, sizeof(chunk) - 1);
+    }
+
+    buffer.append(QByteArray::number(statusCode));
+    buffer.append(' ');
+    buffer.append(reasonPhrase);
+    buffer.append(CRLF);
+}
+
+inline static void appendStatusLine(QByteArray &buffer,
+                                    HttpServerResponse::Options options,
+                                    HttpResponseStatus statusCode)
+{
+    StatusLine line = statusLine(statusCode, options);
+    if (!line.size) {
+        appendStatusLine(buffer, options, int(statusCode),
+                         reasonPhrase(statusCode));
+        return;
+    }
+
+    buffer.append(line.data, line.size);
+}
+
+inline static void insertDefaultHeaders(Headers &headers,
+                                        HttpServerResponse::Options options)
+{
+    if (options.testFlag(HttpServerResponse::DATE_HEADER)) {
+        static const char key[] = "Date";
+        IByteArray name(QByteArray::fromRawData(key, sizeof(key) - 1));
+        if (!headers.contains(name))
+            headers.insert(name, currentHttpDate());
+    }
+}
+
+inline static bool hasContentLength(const Headers &headers)
+{
+    static const char key[] = "Content-Length";
+    return headers.contains(QByteArray::fromRawData(key, sizeof(key) - 1));
+}
+
+// Returns 0 if the header isn't set
+inline static qint64 contentLength(const Headers &headers)
+{
+    static const char key[] = "Content-Length";
+    return headers.value(QByteArray::fromRawData(key, sizeof(key) - 1))
+        .toLongLong();
+}
+
+inline static bool isCompressible(const Headers &headers)
+{
+    if (headers.contains("Content-Encoding"))
+        return false;
+
+    QByteArray type(headers.value("Content-Type"));
+    {
+        int i = type.indexOf(';');
+        if (i != -1)
+            type.truncate(i);
+        type = type.trimmed().toLower();
+    }
+
+    if (type.startsWith("image/"))
+        return type.startsWith("image/svg");
+
+    if (type.startsWith("audio/") || type.startsWith("video/")
+        || type.startsWith("font/woff")) {
+        return false;
+    }
+
+    static const char *const compressedTypes[] = {
+        "application/gzip",
+        "application/x-gzip",
+        "application/zip",
+        "application/zstd",
+        "application/x-bzip2",
+        "application/x-xz",
+        "application/x-7z-compressed",
+        "application/vnd.rar",
+        "application/x-rar-compressed"
+    };
+
+    for (const char *compressedType: compressedTypes) {
+        if (type == compressedType)
+            return false;
+    }
+
+    return true;
+}
+
+inline static int headersSize(const Headers &headers)
+{
+    int size = 0;
+    for (Headers::const_iterator i = headers.constBegin()
+         ;i != headers.constEnd();++i) {
+        size += i.key().size() + i.value().size() + 4;
+    }
+    return size;
+}
+
+inline static void appendHeaders(QByteArray &buffer, const Headers &headers)
+{
+    for (Headers::const_iterator i = headers.constBegin()
+         ;i != headers.constEnd();++i) {
+        buffer.append(i.key());
+        buffer.append(": ", 2);
+        buffer.append(i.value());
+        buffer.append(CRLF);
+    }
+}
+
+/* The headers given to writeHead join the ones set through headers(), so the
+   checks for Content-Length and Content-Encoding see both of them */
+inline static void mergeHeaders(Headers &headers, const Headers &other)
+{
+    for (Headers::const_iterator i = other.constBegin()
+         ;i != other.constEnd();++i) {
+        headers.insert(i.key(), i.value());
+    }
+}
+
+/* Formats the chunk-size line of a chunked message (hexadecimal size + CRLF)
+   into out, which must have room for CHUNK_SIZE_LINE_MAX bytes. Returns the
+   length of the line. */
+inline static int formatChunkSize(char *out, int size)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    char reversed[sizeof(int) * 2];
+    int n = 0;
+    do {
+        reversed[n++] = digits[size & 0xF];
+        size >>= 4;
+    } while (size);
+
+    for (int i = 0;i != n;++i)
+        out[i] = reversed[n - 1 - i];
+
+    out[n++] = '\r';
+    out[n++] = '\n';
+    return n;
+}
+
+inline static void appendChunk(QByteArray &buffer, const QByteArray &chunk)
+{
+    char sizeLine[CHUNK_SIZE_LINE_MAX];
+    buffer.append(sizeLine, formatChunkSize(sizeLine, chunk.size()));
+    buffer.append(chunk);
+    buffer.append(CRLF);
+}
+
 HttpServerResponse::HttpServerResponse(QIODevice &device, Options options,
                                        QObject *parent) :
     QObject(parent),
@@ -74,6 +250,24 @@ bool HttpServerResponse::flush()
     return socket->flush();
 }
 
+bool HttpServerResponse::enableCompression(const Headers &requestHeaders)
+{
+    if (priv->formattingState != Priv::STATUS_LINE
+        && priv->formattingState != Priv::HEADERS) {
+        return false;
+    }
+
+    priv->headers.insert("Vary", "Accept-Encoding");
+
+    int gzip = acceptedQuality(requestHeaders, "gzip");
+    int deflate = acceptedQuality(requestHeaders, "deflate");
+    if (gzip <= 0 && deflate <= 0)
+        return false;
+
+    priv->contentCoding = (gzip >= deflate) ? "gzip" : "deflate";
+    return true;
+}
+
 bool HttpServerResponse::writeContinue()
 {
     if (priv->formattingState != Priv::STATUS_LINE
@@ -97,26 +291,8 @@ bool HttpServerResponse::writeHead(int statusCode,
     if (priv->formattingState != Priv::STATUS_LINE)
         return false;
 
-    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)) {
-        static const char chunk[] = "HTTP/1.0 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    } else {
-        static const char chunk[] = "HTTP/1.1 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    }
-
-    priv->device.write(QByteArray::number(statusCode));
-    priv->device.write(" ", 1);
-    priv->device.write(reasonPhrase);
-    priv->device.write(CRLF);
-
-    for (Headers::const_iterator i = headers.constBegin()
-         ;i != headers.end();++i) {
-        priv->device.write(i.key());
-        priv->device.write(": ", 2);
-        priv->device.write(i.value());
-        priv->device.write(CRLF);
-    }
+    appendStatusLine(priv->head, priv->options, statusCode, reasonPhrase);
+    mergeHeaders(priv->headers, headers);
     priv->formattingState = Priv::HEADERS;
     return true;
 }
@@ -126,18 +302,7 @@ bool HttpServerResponse::writeHead(int statusCode, const QByteArray &reasonPhras
     if (priv->formattingState != Priv::STATUS_LINE)
         return false;
 
-    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)) {
-        static const char chunk[] = "HTTP/1.0 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    } else {
-        static const char chunk[] = "HTTP/1.1 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    }
-
-    priv->device.write(QByteArray::number(statusCode));
-    priv->device.write(" ", 1);
-    priv->device.write(reasonPhrase);
-    priv->device.write(CRLF);
+    appendStatusLine(priv->head, priv->options, statusCode, reasonPhrase);
     priv->formattingState = Priv::HEADERS;
     return true;
 }
@@ -161,26 +326,8 @@ bool HttpServerResponse::writeHead(HttpResponseStatus statusCode,
     if (priv->formattingState != Priv::STATUS_LINE)
         return false;
 
-    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)) {
-        static const char chunk[] = "HTTP/1.0 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    } else {
-        static const char chunk[] = "HTTP/1.1 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    }
-
-    priv->device.write(QByteArray::number(int(statusCode)));
-    priv->device.write(" ", 1);
-    priv->device.write(reasonPhrase(statusCode));
-    priv->device.write(CRLF);
-
-    for (Headers::const_iterator i = headers.constBegin()
-         ;i != headers.end();++i) {
-        priv->device.write(i.key());
-        priv->device.write(": ", 2);
-        priv->device.write(i.value());
-        priv->device.write(CRLF);
-    }
+    appendStatusLine(priv->head, priv->options, statusCode);
+    mergeHeaders(priv->headers, headers);
     priv->formattingState = Priv::HEADERS;
     return true;
 }
@@ -190,18 +337,7 @@ bool HttpServerResponse::writeHead(HttpResponseStatus statusCode)
     if (priv->formattingState != Priv::STATUS_LINE)
         return false;
 
-    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)) {
-        static const char chunk[] = "HTTP/1.0 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    } else {
-        static const char chunk[] = "HTTP/1.1 ";
-        priv->device.write(chunk, sizeof(chunk) - 1);
-    }
-
-    priv->device.write(QByteArray::number(int(statusCode)));
-    priv->device.write(" ", 1);
-    priv->device.write(reasonPhrase(statusCode));
-    priv->device.write(CRLF);
+    appendStatusLine(priv->head, priv->options, statusCode);
     priv->formattingState = Priv::HEADERS;
     return true;
 }
@@ -211,15 +347,39 @@ bool HttpServerResponse::write(const QByteArray &chunk)
     if (!chunk.size())
         return false;
 
+    if (priv->contentCoding.size()
+        && priv->formattingState == Priv::HEADERS) {
+        if (isCompressible(priv->headers)
+            && contentLength(priv->headers) <= COMPRESSION_WINDOW
+            && priv->uncompressedBody.size() + chunk.size()
+            <= COMPRESSION_WINDOW) {
+            priv->uncompressedBody.append(chunk);
+            return true;
+        }
+
+        // Give up compression and send what was buffered as is
+        priv->contentCoding.clear();
+        if (priv->uncompressedBody.size()) {
+            QByteArray buffered;
+            buffered.swap(priv->uncompressedBody);
+            write(buffered);
+        }
+    }
+
     if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)) {
         switch (priv->formattingState) {
         case Priv::STATUS_LINE:
         case Priv::END:
             return false;
         case Priv::HEADERS:
+            // The body is buffered only to compute the missing Content-Length
+            if (priv->http10Buffer.size() || !hasContentLength(priv->headers)) {
+                priv->http10Buffer.push_back(chunk);
+                return true;
+            }
+            break;
         default:
-            priv->http10Buffer.push_back(chunk);
-            return true;
+            break;
         }
     }
 
@@ -230,7 +390,9 @@ bool HttpServerResponse::write(const QByteArray &chunk)
         return false;
     case Priv::HEADERS:
     {
-        if (priv->options.testFlag(HttpServerResponse::KEEP_ALIVE)) {
+        if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)) {
+            // HTTP/1.0 connections are always closed at the end
+        } else if (priv->options.testFlag(HttpServerResponse::KEEP_ALIVE)) {
             static const char key[] = "Connection", value[] = "keep-alive";
             priv->headers.replace(QByteArray::fromRawData(key, sizeof(key) - 1),
                                   QByteArray::fromRawData(value,
@@ -241,23 +403,37 @@ bool HttpServerResponse::write(const QByteArray &chunk)
                                   QByteArray::fromRawData(value,
                                                           sizeof(value) - 1));
         }
-        priv->headers.insert("Transfer-Encoding", "chunked");
-
-        for (Headers::iterator i = priv->headers.begin()
-             ;i != priv->headers.end();++i) {
-            priv->device.write(i.key());
-            priv->device.write(": ", 2);
-            priv->device.write(i.value());
-            priv->device.write(CRLF);
-        }
-        priv->device.write(CRLF);
+        priv->chunked = !hasContentLength(priv->headers);
+        if (priv->chunked)
+            priv->headers.insert("Transfer-Encoding", "chunked");
+        insertDefaultHeaders(priv->headers, priv->options);
+
+        // The head and the first chunk are sent in a single write
+        QByteArray &head = priv->head;
+        head.reserve(head.size() + headersSize(priv->headers) + 2
+                     + CHUNK_SIZE_LINE_MAX + chunk.size() + 2);
+        appendHeaders(head, priv->headers);
+        head.append(CRLF);
+        if (priv->chunked)
+            appendChunk(head, chunk);
+        else
+            head.append(chunk);
+
+        priv->device.write(head);
+        head.clear();
 
         priv->formattingState = Priv::MESSAGE_BODY;
+        break;
     }
     case Priv::MESSAGE_BODY:
     {
-        priv->device.write(QByteArray::number(chunk.size(), 16));
-        priv->device.write(CRLF);
+        if (!priv->chunked) {
+            priv->device.write(chunk);
+            break;
+        }
+
+        char sizeLine[CHUNK_SIZE_LINE_MAX];
+        priv->device.write(sizeLine, formatChunkSize(sizeLine, chunk.size()));
         priv->device.write(chunk);
         priv->device.write(CRLF);
     }
@@ -267,8 +443,12 @@ bool HttpServerResponse::write(const QByteArray &chunk)
 
 bool HttpServerResponse::addTrailers(const Headers &headers)
 {
-    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0))
+    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)
+        || !priv->chunked) {
         return false;
+    }
+
+    QByteArray buffer;
 
     switch (priv->formattingState) {
     case Priv::STATUS_LINE:
@@ -276,17 +456,13 @@ bool HttpServerResponse::addTrailers(const Headers &headers)
     case Priv::HEADERS:
         return false;
     case Priv::MESSAGE_BODY:
-        priv->device.write("0\r\n");
+        buffer.append(LAST_CHUNK);
         priv->formattingState = Priv::TRAILERS;
     case Priv::TRAILERS:
     {
-        for (Headers::const_iterator i = headers.constBegin()
-             ;i != headers.end();++i) {
-            priv->device.write(i.key());
-            priv->device.write(": ", 2);
-            priv->device.write(i.value());
-            priv->device.write(CRLF);
-        }
+        buffer.reserve(buffer.size() + headersSize(headers));
+        appendHeaders(buffer, headers);
+        priv->device.write(buffer);
     }
     } // switch (priv->formattingState)
     return true;
@@ -295,8 +471,12 @@ bool HttpServerResponse::addTrailers(const Headers &headers)
 bool HttpServerResponse::addTrailer(const QByteArray &headerName,
                                     const QByteArray &headerValue)
 {
-    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0))
+    if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)
+        || !priv->chunked) {
         return false;
+    }
+
+    QByteArray buffer;
 
     switch (priv->formattingState) {
     case Priv::STATUS_LINE:
@@ -304,14 +484,17 @@ bool HttpServerResponse::addTrailer(const QByteArray &headerName,
     case Priv::HEADERS:
         return false;
     case Priv::MESSAGE_BODY:
-        priv->device.write(LAST_CHUNK);
+        buffer.append(LAST_CHUNK);
         priv->formattingState = Priv::TRAILERS;
     case Priv::TRAILERS:
     {
-        priv->device.write(headerName);
-        priv->device.write(": ", 2);
-        priv->device.write(headerValue);
-        priv->device.write(CRLF);
+        buffer.reserve(buffer.size() + headerName.size()
+                       + headerValue.size() + 4);
+        buffer.append(headerName);
+        buffer.append(": ", 2);
+        buffer.append(headerValue);
+        buffer.append(CRLF);
+        priv->device.write(buffer);
     }
     } // switch (priv->formattingState)
     return true;
@@ -319,6 +502,30 @@ bool HttpServerResponse::addTrailer(const QByteArray &headerName,
 
 bool HttpServerResponse::end(const QByteArray &chunk)
 {
+    if (priv->contentCoding.size()
+        && priv->formattingState == Priv::HEADERS) {
+        QByteArray body;
+        body.swap(priv->uncompressedBody);
+        body.append(chunk);
+
+        QByteArray coding;
+        coding.swap(priv->contentCoding);
+
+        if (body.size() >= COMPRESSION_MIN_SIZE
+            && isCompressible(priv->headers)) {
+            QByteArray compressed(coding == "gzip" ? gzipCompress(body)
+                                  : zlibCompress(body));
+            if (compressed.size() < body.size()) {
+                priv->headers.replace("Content-Encoding", coding);
+                priv->headers.replace("Content-Length",
+                                      QByteArray::number(compressed.size()));
+                return end(compressed);
+            }
+        }
+
+        return end(body);
+    }
+
     switch (priv->formattingState) {
     case Priv::STATUS_LINE:
     case Priv::END:
@@ -345,10 +552,14 @@ bool HttpServerResponse::end(const QByteArray &chunk)
 
         if (priv->options.testFlag(HttpServerResponse::HTTP_1_1)
             && continue_to_message_body) {
-            static const char key[] = "Transfer-Encoding", value[] = "chunked";
-            priv->headers
-                .insert(QByteArray::fromRawData(key, sizeof(key) - 1),
-                        QByteArray::fromRawData(value, sizeof(value) - 1));
+            priv->chunked = !hasContentLength(priv->headers);
+            if (priv->chunked) {
+                static const char key[] = "Transfer-Encoding",
+                    value[] = "chunked";
+                priv->headers
+                    .insert(QByteArray::fromRawData(key, sizeof(key) - 1),
+                            QByteArray::fromRawData(value, sizeof(value) - 1));
+            }
         } else {
             static const char key[] = "Content-Length";
             priv->headers.replace(QByteArray
@@ -357,54 +568,77 @@ bool HttpServerResponse::end(const QByteArray &chunk)
                                                      + chunk.size()));
         }
 
-        for (Headers::iterator i = priv->headers.begin()
-             ;i != priv->headers.end();++i) {
-            priv->device.write(i.key());
-            priv->device.write(": ", 2);
-            priv->device.write(i.value());
-            priv->device.write(CRLF);
-        }
-        priv->device.write(CRLF);
+        insertDefaultHeaders(priv->headers, priv->options);
+
+        // The whole message is sent in a single write
+        QByteArray &head = priv->head;
+        head.reserve(head.size() + headersSize(priv->headers) + 2
+                     + priv->http10Buffer.size() + CHUNK_SIZE_LINE_MAX
+                     + chunk.size() + int(sizeof(chunkedTail)) - 1);
+        appendHeaders(head, priv->headers);
+        head.append(CRLF);
+
+        if (!continue_to_message_body) {
+            priv->device.write(head);
+            head.clear();
 
-        if (continue_to_message_body) {
-            priv->formattingState = Priv::MESSAGE_BODY;
-        } else {
             if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)
                 || !priv->options.testFlag(HttpServerResponse::KEEP_ALIVE)) {
                 priv->device.close();
             }
+        } else if (priv->options.testFlag(HttpServerResponse::HTTP_1_1)) {
+            if (priv->chunked) {
+                char sizeLine[CHUNK_SIZE_LINE_MAX];
+                head.append(sizeLine, formatChunkSize(sizeLine, chunk.size()));
+                head.append(chunk);
+                head.append(CHUNKED_TAIL);
+            } else {
+                head.append(chunk);
+            }
 
-            priv->formattingState = Priv::END;
-            emit finished();
-            return true;
+            priv->device.write(head);
+            head.clear();
+
+            if (!priv->options.testFlag(HttpServerResponse::KEEP_ALIVE))
+                priv->device.close();
+        } else {
+            head.append(priv->http10Buffer);
+            head.append(chunk);
+            priv->http10Buffer.clear();
+
+            priv->device.write(head);
+            head.clear();
+            priv->device.close();
         }
+
+        priv->formattingState = Priv::END;
+        emit finished();
+        break;
     }
     case Priv::MESSAGE_BODY:
     {
-        if (chunk.size()) {
-            if (priv->options.testFlag(HttpServerResponse::HTTP_1_1)) {
-                priv->device.write(QByteArray::number(chunk.size(), 16));
-                priv->device.write(CRLF);
-            } else if (priv->http10Buffer.size()) {
-                priv->device.write(priv->http10Buffer);
-                priv->http10Buffer.clear();
-            }
+        if (!priv->chunked) {
+            if (chunk.size())
+                priv->device.write(chunk);
+        } else if (chunk.size()) {
+            char sizeLine[CHUNK_SIZE_LINE_MAX];
+            priv->device.write(sizeLine,
+                               formatChunkSize(sizeLine, chunk.size()));
             priv->device.write(chunk);
-            if (priv->options.testFlag(HttpServerResponse::HTTP_1_1))
-                priv->device.write(CRLF);
-        } else if (priv->http10Buffer.size()) {
-            priv->device.write(priv->http10Buffer);
-            priv->http10Buffer.clear();
-        }
-        if (priv->options.testFlag(HttpServerResponse::HTTP_1_1)) {
-            priv->device.write(LAST_CHUNK);
-            priv->formattingState = Priv::TRAILERS;
+            priv->device.write(CHUNKED_TAIL);
         } else {
+            static const char tail[] = "0\r\n\r\n";
+            priv->device.write(tail, sizeof(tail) - 1);
+        }
+
+        if (priv->options.testFlag(HttpServerResponse::HTTP_1_0)
+            || !priv->options.testFlag(HttpServerResponse::KEEP_ALIVE)) {
             priv->device.close();
-            priv->formattingState = Priv::END;
-            emit finished();
-            break;
         }
+
+        priv->formattingState = Priv::END;
+        emit finished();
+        break;
     }
     case Priv::TRAILERS:
     {
@@ -162,7 +162,18 @@ public:
           \note
           Only supported in HTTP/1.1 connections.
           */
-        KEEP_ALIVE         = 1 << 2
+        KEEP_ALIVE         = 1 << 2,
+        /*!
+          A "Date" header with the current date is added to the response,
+          unless you set one yourself.
+
+          The formatted date is cached per thread and regenerated at most once
+          per second.
+
+          \since
+          1.5
+          */
+        DATE_HEADER        = 1 << 3
     };
     Q_DECLARE_FLAGS(Options, Option)
 
@@ -247,6 +258,38 @@ public:
       */
     bool flush();
 
+    /*!
+      Enables the compression of the message body using the best content-coding
+      ("gzip" or "deflate") accepted by the user agent, according to the
+      Accept-Encoding headers found in \p requestHeaders.
+
+      The body passed to HttpServerResponse::write and HttpServerResponse::end
+      is buffered and compressed when the message ends, and it's sent with the
+      "Content-Encoding" and "Content-Length" headers. The body is sent
+      uncompressed, as usual, if:
+        - it's smaller than 1 KiB;
+        - it grows beyond 1 MiB, in which case the buffered data is sent as soon
+          as the limit is reached and compression is abandoned (the
+          compression isn't done chunk by chunk, as Qt only offers one-shot
+          compression functions);
+        - the "Content-Length" header announces more than 1 MiB, in which case
+          nothing is buffered;
+        - the "Content-Type" header names an already compressed format (e.g.
+          images, audio, video and archives) or the "Content-Encoding" header is
+          already set;
+        - compression doesn't make it smaller.
+
+      "Vary: Accept-Encoding" is added to the response headers in any case.
+
+      It must be called before the first piece of body is written.
+
+      \return true if a content-coding accepted by the user agent was found.
+
+      \since
+      1.5
+      */
+    bool enableCompression(const Headers &requestHeaders);
+
 signals:
     /*!
       This signal is emitted when all bytes from the HTTP response message are
@@ -287,6 +330,13 @@ public slots:
       \param statusCode The status code is a 3-digit HTTP status code.
       \param reasonPhrase A human-readable reasonPhrase.
       \param headers The response headers.
+
+      \note
+      Since Tufão 1.5, the status line and the headers are buffered and
+      written to the device, along with the first piece of body, in a single
+      write call. \p headers are added to Tufao::HttpServerResponse::headers,
+      so they're taken into account by the framing of the body (e.g.
+      "Content-Length") and by the compression.
       */
     bool writeHead(int statusCode, const QByteArray &reasonPhrase,
                    const Headers &headers);
@@ -349,6 +399,10 @@ public slots:
 
       If you call this function with a empty byte array, it will do nothing.
 
+      If you set the "Content-Length" header before the first call, the body is
+      sent as is, without chunked encoding, and it's your responsibility to
+      send exactly that many bytes. Trailers aren't available in this case.
+
       \note
       HTTP/1.0 user agents don't support chunked entities. To overcome this
       limitation, Tufao::HttpServerResponse will buffer the chunks and send the
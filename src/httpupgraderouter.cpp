@@ -18,10 +18,9 @@
 
 #include "priv/httpupgraderouter.h"
 #include "httpserverrequest.h"
+#include "routeparameters.h"
 
-#include <QtCore/QStringList>
 #include <QtCore/QUrl>
-#include <QtCore/QVariant>
 
 #include <algorithm>
 
@@ -50,53 +49,103 @@ int HttpUpgradeRouter::map(Mapping map)
 {
     int i = priv->mappings.size();
     priv->mappings.push_back(map);
+    priv->dirty = true;
     return i;
 }
 
 int HttpUpgradeRouter::map(std::initializer_list<Mapping> map)
 {
     int i = priv->mappings.size();
-    std::copy(std::begin(map), std::end(map), std::end(priv->mappings));
+    std::copy(std::begin(map), std::end(map),
+              std::back_inserter(priv->mappings));
+    priv->dirty = true;
     return i;
 }
 
 void HttpUpgradeRouter::unmap(int index)
 {
     priv->mappings.remove(index);
+    priv->dirty = true;
 }
 
 void HttpUpgradeRouter::clear()
 {
     priv->mappings.clear();
+    priv->dirty = true;
+}
+
+void HttpUpgradeRouter::setCacheSize(int entries)
+{
+    priv->cache.setMaxCost(entries);
+}
+
+int HttpUpgradeRouter::cacheSize() const
+{
+    return priv->cache.maxCost();
 }
 
 bool HttpUpgradeRouter::handleUpgrade(HttpServerRequest &request,
                                       const QByteArray &head)
 {
+    if (priv->dirty)
+        priv->update();
+
     const QString path{request.url().path()};
+    const Priv::Matches matches{priv->lookup(path)};
+
+    if (matches.isEmpty())
+        return false;
 
-    for (const auto &mapping: priv->mappings) {
-        QRegularExpressionMatch match{mapping.path.match(path)};
+    RouteParameters &parameters = request.routeParameters();
+    const int previous = parameters.size();
 
-        if (match.hasMatch()) {
-            QStringList args{match.capturedTexts().mid(1)};
-            QVariant backup{request.customData()};
+    // A declining handler must not leak its custom data to the next ones
+    const QVariant backup{request.customData()};
 
-            if (args.size()) {
-                QVariantMap options{backup.toMap()};
-                options["args"] = options["ags"].toStringList() + args;
-                request.setCustomData(options);
-            }
+    for (const auto &match: matches) {
+        const Mapping &mapping = priv->mappings[match.index];
+        appendRouteParameters(parameters, path, match.captures,
+                              priv->captureNames[match.index]);
 
-            if (mapping.handler(request, head))
-                return true;
+        if (mapping.handler(request, head))
+            return true;
 
-            if (args.size())
-                request.setCustomData(backup);
-        }
+        parameters.truncate(previous);
+        request.setCustomData(backup);
     }
 
     return false;
 }
 
+void HttpUpgradeRouter::Priv::update()
+{
+    routes.clear();
+    cache.clear();
+
+    captureNames.clear();
+    captureNames.reserve(mappings.size());
+
+    for (int i = 0;i != mappings.size();++i) {
+        captureNames.push_back(mappings[i].path.namedCaptureGroups());
+        routes.insert(mappings[i].path, i);
+    }
+
+    dirty = false;
+}
+
+HttpUpgradeRouter::Priv::Matches
+HttpUpgradeRouter::Priv::lookup(const QString &path)
+{
+    if (const Matches *cached = cache.object(path))
+        return *cached;
+
+    Matches matches;
+    routes.match(path, matches);
+
+    if (cache.maxCost() > 0)
+        cache.insert(path, new Matches(matches));
+
+    return matches;
+}
+
 } // namespace Tufao
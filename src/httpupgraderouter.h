@@ -40,7 +40,10 @@ namespace Tufao {
 
   The type of mapping rules used in this class provides a predictable behaviour
   that is simple to understand and allow the use of caching algorithms to
-  improve the performance.
+  improve the performance. The mappings are matched just like in
+  HttpServerRequestRouter: simple patterns are compiled into a tree and the
+  result of the matching is cached for the most requested paths (see
+  setCacheSize).
 
   When the router finds one matching request handler, it will call it. If the
   found handler cannot handle the request (this is indicated by the return
@@ -149,33 +152,47 @@ public:
       */
     void clear();
 
+    /*!
+      Sets the maximum number of paths whose matching mappings are remembered
+      by the router to \p entries. The least recently used paths are forgotten
+      first and any change in the mappings forgets all of them.
+
+      A value of 0 disables the cache. The default value is 1024.
+
+      \since
+      1.5
+     */
+    void setCacheSize(int entries);
+
+    /*!
+      Returns the maximum number of paths remembered by the router.
+
+      \sa
+      setCacheSize
+
+      \since
+      1.5
+     */
+    int cacheSize() const;
+
 public slots:
     /*!
       It will route the request to the right handler.
 
       The handler will have access to the list of captured texts by the regular
-      expression using HttpServerRequest::customData.
-
-      \note
-      The router won't touch the HttpServerRequest::customData if the regex
-      don't capture any text.
+      expression using HttpServerRequest::routeParameters. The captures are
+      appended before the handler is called and removed if it declines the
+      request, along with any change it made to HttpServerRequest::customData.
+      Named capture groups can also be accessed by name.
 
       See example below:
 
-      \include custom_data.cpp
-
-      If there is already an object set for this request, the router will do the
-      following steps:
-
-      1. If the object is not a QVariantMap, override it
-      2. If the object already has a item with the key "args", but the value is
-         not a QStringList, override the item
-      3. Append the list of captured texts in the object["args"]
+      \include route_parameters.cpp
 
       \note
-      The request's custom data is copied at the beginning and is used to
-      restore the custom data state before call every handler. The state will
-      also be restored if no handlers are capable of handle the request.
+      For compatibility, the captured texts are also available in the "args"
+      item of HttpServerRequest::customData (see
+      HttpServerRequestRouter::handleRequest).
 
       \return
       Returns true if one handler able to respond the request is found.
@@ -0,0 +1,126 @@
+/*
+  Copyright (c) 2016 Vinícius dos Santos Oliveira
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+  */
+
+#include "ibytearray.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QVarLengthArray>
+
+#include <cstring>
+
+namespace Tufao {
+
+// The comparisons and hashes process 8 bytes at a time, folding the ASCII
+// letters of the whole word with integer arithmetic. Words containing non-ASCII
+// bytes are folded byte by byte, using the same Latin-1 rules as qstricmp.
+
+static const quint64 ONES = Q_UINT64_C(0x0101010101010101);
+static const quint64 HIGH_BITS = Q_UINT64_C(0x8080808080808080);
+
+static inline quint64 loadWord(const char *data)
+{
+    quint64 word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+// Loads the last size (< 8) bytes padded with zeros
+static inline quint64 loadTail(const char *data, int size)
+{
+    quint64 word = 0;
+    std::memcpy(&word, data, size);
+    return word;
+}
+
+static inline uchar foldByte(uchar c)
+{
+    if ((c >= 'A' && c <= 'Z') || (c >= 0xc0 && c <= 0xde && c != 0xd7))
+        return c + 0x20;
+
+    return c;
+}
+
+static inline quint64 foldWord(quint64 word)
+{
+    if (word & HIGH_BITS) {
+        uchar bytes[sizeof(word)];
+        std::memcpy(bytes, &word, sizeof(word));
+
+        for (auto &byte: bytes)
+            byte = foldByte(byte);
+
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+
+    // No byte has the high bit set, so the additions don't carry between
+    // bytes. The high bit of each byte of aboveA is set for bytes >= 'A' and
+    // the high bit of each byte of aboveZ is set for bytes > 'Z'.
+    const quint64 aboveA = word + ONES * (0x80 - 'A');
+    const quint64 aboveZ = word + ONES * (0x80 - 'Z' - 1);
+    const quint64 upper = aboveA & ~aboveZ & HIGH_BITS;
+
+    // 0x80 >> 2 is the difference between the cases
+    return word | (upper >> 2);
+}
+
+bool caseInsensitiveEqual(const char *lhs, const char *rhs, int size)
+{
+    int i = 0;
+
+    for (;i + 8 <= size;i += 8) {
+        const quint64 a = loadWord(lhs + i);
+        const quint64 b = loadWord(rhs + i);
+
+        if (a != b && foldWord(a) != foldWord(b))
+            return false;
+    }
+
+    if (i == size)
+        return true;
+
+    const quint64 a = loadTail(lhs + i, size - i);
+    const quint64 b = loadTail(rhs + i, size - i);
+    return a == b || foldWord(a) == foldWord(b);
+}
+
+uint caseInsensitiveHash(const char *data, int size, uint seed)
+{
+    // Code built against Tufão 1.4 has qHash(key.toLower()) inlined, so the
+    // value must stay the same. Only the allocation is avoided.
+    QVarLengthArray<char, 256> folded(size);
+    int i = 0;
+
+    for (;i + 8 <= size;i += 8) {
+        const quint64 word = foldWord(loadWord(data + i));
+        std::memcpy(folded.data() + i, &word, sizeof(word));
+    }
+
+    if (i != size) {
+        const quint64 word = foldWord(loadTail(data + i, size - i));
+        std::memcpy(folded.data() + i, &word, size - i);
+    }
+
+    return qHashBits(folded.constData(), size_t(size), seed);
+}
+
+} // namespace Tufao
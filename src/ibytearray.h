@@ -28,6 +28,30 @@
 
 namespace Tufao {
 
+/*!
+  Returns true if the first \p size bytes of \p lhs and \p rhs are equal,
+  ignoring case differences of letters. The same Latin-1 case folding used by
+  qstricmp is used.
+
+  \since
+  1.5
+  */
+TUFAO_EXPORT bool caseInsensitiveEqual(const char *lhs, const char *rhs,
+                                       int size);
+
+/*!
+  Returns a hash of \p size bytes at \p data that ignores case differences of
+  letters, as defined by Tufao::caseInsensitiveEqual.
+
+  The result is the same as `qHash(QByteArray(data, size).toLower(), seed)`,
+  but no memory is allocated for keys up to 256 bytes.
+
+  \since
+  1.5
+  */
+TUFAO_EXPORT uint caseInsensitiveHash(const char *data, int size,
+                                      uint seed = 0);
+
 /*!
   This class provides a case insensitive QByteArray. It inherits from QByteArray
   and provides non-member functions to overload the common operators:
@@ -46,7 +70,10 @@ namespace Tufao {
   \par
   \note
   All member functions of this class are inlined and should add the minimum (if
-  any) of overhead.
+  any) of overhead. The equality operators and qHash use
+  Tufao::caseInsensitiveEqual and Tufao::caseInsensitiveHash, which compare
+  and fold 8 bytes at a time without allocating memory. The hash values are
+  the same computed by previous versions.
   */
 class TUFAO_EXPORT IByteArray : public QByteArray
 {
@@ -89,7 +116,8 @@ inline IByteArray &IByteArray::operator =(const QByteArray &ba)
 
 inline bool operator !=(const IByteArray &lhs, const IByteArray &rhs)
 {
-    return qstricmp(lhs.constData(), rhs.constData()) != 0;
+    return lhs.size() != rhs.size()
+        || !caseInsensitiveEqual(lhs.constData(), rhs.constData(), lhs.size());
 }
 
 inline bool operator <(const IByteArray &lhs, const IByteArray &rhs)
@@ -104,7 +132,8 @@ inline bool operator <=(const IByteArray &lhs, const IByteArray &rhs)
 
 inline bool operator ==(const IByteArray &lhs, const IByteArray &rhs)
 {
-    return qstricmp(lhs.constData(), rhs.constData()) == 0;
+    return lhs.size() == rhs.size()
+        && caseInsensitiveEqual(lhs.constData(), rhs.constData(), lhs.size());
 }
 
 inline bool operator >(const IByteArray &lhs, const IByteArray &rhs)
@@ -119,7 +148,7 @@ inline bool operator >=(const IByteArray &lhs, const IByteArray &rhs)
 
 inline uint qHash(const IByteArray &key)
 {
-    return qHash(key.toLower());
+    return caseInsensitiveHash(key.constData(), key.size());
 }
 
 } // namespace Tufao
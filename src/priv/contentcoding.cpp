@@ -0,0 +1,493 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "contentcoding.h"
+
+namespace Tufao {
+
+int acceptedQuality(const QList<QByteArray> &acceptEncoding,
+                    const char *coding, bool wildcard)
+{
+    int quality = -1;
+    int anyQuality = -1;
+
+    foreach (const QByteArray &value, acceptEncoding) {
+        foreach (const QByteArray &element, value.split(',')) {
+            int i = element.indexOf(';');
+            QByteArray name(element.left(i).trimmed());
+            int q = 1000;
+
+            if (i != -1) {
+                QByteArray parameter(element.mid(i + 1).trimmed());
+                if (parameter.startsWith("q=") || parameter.startsWith("Q=")) {
+                    bool ok;
+                    double number = parameter.mid(2).toDouble(&ok);
+                    q = ok ? qBound(0, qRound(number * 1000), 1000) : 0;
+                }
+            }
+
+            if (qstricmp(name.constData(), coding) == 0
+                || (qstrcmp(coding, "gzip") == 0
+                    && qstricmp(name.constData(), "x-gzip") == 0)) {
+                quality = qMax(quality, q);
+            } else if (name == "*") {
+                anyQuality = q;
+            }
+        }
+    }
+
+    return (quality != -1 || !wildcard) ? quality : anyQuality;
+}
+
+// qCompress' size prefix, zlib header and adler32 trailer
+static const int QCOMPRESS_PREFIX_SIZE = 4;
+static const int ZLIB_HEADER_SIZE = 2;
+static const int ZLIB_TRAILER_SIZE = 4;
+
+QByteArray rawDeflate(const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        // A final empty block with fixed Huffman codes
+        static const char empty[] = {0x03, 0x00};
+        return QByteArray(empty, sizeof(empty));
+    }
+
+    QByteArray compressed(qCompress(data));
+    return compressed.mid(QCOMPRESS_PREFIX_SIZE + ZLIB_HEADER_SIZE,
+                          compressed.size() - QCOMPRESS_PREFIX_SIZE
+                          - ZLIB_HEADER_SIZE - ZLIB_TRAILER_SIZE);
+}
+
+QByteArray zlibCompress(const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        // Header, final empty block and adler32 of nothing
+        static const char empty[] = {0x78, char(0x9c), 0x03, 0x00,
+                                     0x00, 0x00, 0x00, 0x01};
+        return QByteArray(empty, sizeof(empty));
+    }
+
+    return qCompress(data).mid(QCOMPRESS_PREFIX_SIZE);
+}
+
+static inline void appendLittleEndian(QByteArray &buffer, quint32 value)
+{
+    buffer.append(char(value & 0xff));
+    buffer.append(char((value >> 8) & 0xff));
+    buffer.append(char((value >> 16) & 0xff));
+    buffer.append(char((value >> 24) & 0xff));
+}
+
+QByteArray gzipCompress(const QByteArray &data)
+{
+    // ID1, ID2, CM (deflate), FLG, MTIME (unknown), XFL, OS (unknown)
+    static const char header[] = {0x1f, char(0x8b), 0x08, 0x00,
+                                  0x00, 0x00, 0x00, 0x00,
+                                  0x00, char(0xff)};
+
+    QByteArray deflated(rawDeflate(data));
+
+    QByteArray buffer;
+    buffer.reserve(int(sizeof(header)) + deflated.size() + 8);
+    buffer.append(header, sizeof(header));
+    buffer.append(deflated);
+    appendLittleEndian(buffer, crc32(data));
+    appendLittleEndian(buffer, quint32(data.size()));
+    return buffer;
+}
+
+static const quint32 *crc32Table()
+{
+    static const struct Table
+    {
+        Table()
+        {
+            for (quint32 i = 0;i != 256;++i) {
+                quint32 c = i;
+                for (int k = 0;k != 8;++k)
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                values[i] = c;
+            }
+        }
+
+        quint32 values[256];
+    } table;
+
+    return table.values;
+}
+
+quint32 crc32(const QByteArray &data)
+{
+    const quint32 *table = crc32Table();
+    const uchar *i = reinterpret_cast<const uchar*>(data.constData());
+    const uchar *end = i + data.size();
+
+    quint32 crc = 0xffffffffu;
+    for (;i != end;++i)
+        crc = table[(crc ^ *i) & 0xff] ^ (crc >> 8);
+
+    return crc ^ 0xffffffffu;
+}
+
+namespace {
+
+struct BitReader
+{
+    BitReader(const char *data, int size) :
+        data(reinterpret_cast<const uchar*>(data)), size(size), position(0),
+        buffer(0), count(0)
+    {}
+
+    // Returns -1 if the input is exhausted
+    int bits(int n)
+    {
+        while (count < n) {
+            if (position == size)
+                return -1;
+
+            buffer |= quint32(data[position++]) << count;
+            count += 8;
+        }
+
+        int value = int(buffer & ((1u << n) - 1));
+        buffer >>= n;
+        count -= n;
+        return value;
+    }
+
+    // Discards the remaining bits of the current byte
+    void align()
+    {
+        buffer = 0;
+        count = 0;
+    }
+
+    // No complete block fits in the remaining bits
+    bool atEnd() const
+    {
+        return position == size && count < 8;
+    }
+
+    const uchar *data;
+    int size;
+    int position;
+    quint32 buffer;
+    int count;
+};
+
+static const int MAX_BITS = 15;
+static const int MAX_LITERAL_CODES = 288;
+static const int MAX_DISTANCE_CODES = 30;
+
+struct Huffman
+{
+    // Number of codes of each length and the symbols ordered by code
+    quint16 counts[MAX_BITS + 1];
+    quint16 symbols[MAX_LITERAL_CODES];
+};
+
+// Incomplete codes are accepted, as deflate allows a lone distance code
+bool buildHuffman(Huffman &h, const quint8 *lengths, int n)
+{
+    for (int i = 0;i <= MAX_BITS;++i)
+        h.counts[i] = 0;
+    for (int i = 0;i != n;++i)
+        ++h.counts[lengths[i]];
+
+    int left = 1;
+    for (int i = 1;i <= MAX_BITS;++i) {
+        left <<= 1;
+        left -= h.counts[i];
+        if (left < 0)
+            return false;
+    }
+
+    quint16 offsets[MAX_BITS + 1];
+    offsets[1] = 0;
+    for (int i = 1;i != MAX_BITS;++i)
+        offsets[i + 1] = offsets[i] + h.counts[i];
+
+    for (int i = 0;i != n;++i) {
+        if (lengths[i])
+            h.symbols[offsets[lengths[i]]++] = quint16(i);
+    }
+
+    return true;
+}
+
+// Returns -1 if the input is exhausted or the code is invalid
+int decodeSymbol(BitReader &in, const Huffman &h)
+{
+    int code = 0;
+    int first = 0;
+    int index = 0;
+
+    for (int length = 1;length <= MAX_BITS;++length) {
+        int bit = in.bits(1);
+        if (bit < 0)
+            return -1;
+
+        code |= bit;
+        int count = h.counts[length];
+        if (code - count < first)
+            return h.symbols[index + (code - first)];
+
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+const quint16 LENGTH_BASES[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+    67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const quint8 LENGTH_EXTRA_BITS[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+    5, 5, 5, 5, 0
+};
+const quint16 DISTANCE_BASES[MAX_DISTANCE_CODES] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+    769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const quint8 DISTANCE_EXTRA_BITS[MAX_DISTANCE_CODES] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+    11, 11, 12, 12, 13, 13
+};
+
+bool inflateCodes(BitReader &in, const Huffman &literals,
+                  const Huffman &distances, QByteArray &out, int maxSize)
+{
+    for (;;) {
+        int symbol = decodeSymbol(in, literals);
+        if (symbol < 0)
+            return false;
+
+        if (symbol < 256) {
+            if (out.size() >= maxSize)
+                return false;
+
+            out.append(char(symbol));
+            continue;
+        }
+
+        if (symbol == 256)
+            return true;
+
+        symbol -= 257;
+        if (symbol >= 29)
+            return false;
+
+        int extra = in.bits(LENGTH_EXTRA_BITS[symbol]);
+        if (extra < 0)
+            return false;
+        int length = LENGTH_BASES[symbol] + extra;
+
+        symbol = decodeSymbol(in, distances);
+        if (symbol < 0 || symbol >= MAX_DISTANCE_CODES)
+            return false;
+
+        extra = in.bits(DISTANCE_EXTRA_BITS[symbol]);
+        if (extra < 0)
+            return false;
+        int distance = DISTANCE_BASES[symbol] + extra;
+
+        if (distance > out.size() || length > maxSize - out.size())
+            return false;
+
+        // The source and the destination may overlap, so copy byte by byte
+        int start = out.size();
+        out.resize(start + length);
+        char *dst = out.data() + start;
+        const char *src = dst - distance;
+        for (int i = 0;i != length;++i)
+            dst[i] = src[i];
+    }
+}
+
+bool inflateStored(BitReader &in, QByteArray &out, int maxSize)
+{
+    in.align();
+
+    if (in.size - in.position < 4)
+        return false;
+
+    const uchar *header = in.data + in.position;
+    int length = header[0] | (header[1] << 8);
+    int complement = header[2] | (header[3] << 8);
+    in.position += 4;
+
+    if (length != (~complement & 0xffff)
+        || length > in.size - in.position
+        || length > maxSize - out.size()) {
+        return false;
+    }
+
+    out.append(reinterpret_cast<const char*>(in.data + in.position), length);
+    in.position += length;
+    return true;
+}
+
+bool inflateFixed(BitReader &in, QByteArray &out, int maxSize)
+{
+    static const struct Tables
+    {
+        Tables()
+        {
+            quint8 lengths[MAX_LITERAL_CODES];
+            int i = 0;
+            for (;i != 144;++i)
+                lengths[i] = 8;
+            for (;i != 256;++i)
+                lengths[i] = 9;
+            for (;i != 280;++i)
+                lengths[i] = 7;
+            for (;i != MAX_LITERAL_CODES;++i)
+                lengths[i] = 8;
+            buildHuffman(literals, lengths, MAX_LITERAL_CODES);
+
+            for (i = 0;i != MAX_DISTANCE_CODES;++i)
+                lengths[i] = 5;
+            buildHuffman(distances, lengths, MAX_DISTANCE_CODES);
+        }
+
+        Huffman literals;
+        Huffman distances;
+    } tables;
+
+    return inflateCodes(in, tables.literals, tables.distances, out, maxSize);
+}
+
+bool inflateDynamic(BitReader &in, QByteArray &out, int maxSize)
+{
+    static const quint8 order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+
+    int nLiterals = in.bits(5);
+    int nDistances = in.bits(5);
+    int nCodes = in.bits(4);
+    if (nLiterals < 0 || nDistances < 0 || nCodes < 0)
+        return false;
+
+    nLiterals += 257;
+    nDistances += 1;
+    nCodes += 4;
+    if (nLiterals > MAX_LITERAL_CODES || nDistances > MAX_DISTANCE_CODES)
+        return false;
+
+    quint8 lengths[MAX_LITERAL_CODES + MAX_DISTANCE_CODES] = {};
+    for (int i = 0;i != nCodes;++i) {
+        int length = in.bits(3);
+        if (length < 0)
+            return false;
+        lengths[order[i]] = quint8(length);
+    }
+
+    Huffman codes;
+    if (!buildHuffman(codes, lengths, 19))
+        return false;
+
+    for (int i = 0;i != nLiterals + nDistances;) {
+        int symbol = decodeSymbol(in, codes);
+        if (symbol < 0)
+            return false;
+
+        if (symbol < 16) {
+            lengths[i++] = quint8(symbol);
+            continue;
+        }
+
+        quint8 length = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (i == 0)
+                return false;
+            length = lengths[i - 1];
+            repeat = in.bits(2);
+            repeat += repeat < 0 ? 0 : 3;
+        } else if (symbol == 17) {
+            repeat = in.bits(3);
+            repeat += repeat < 0 ? 0 : 3;
+        } else {
+            repeat = in.bits(7);
+            repeat += repeat < 0 ? 0 : 11;
+        }
+
+        if (repeat < 0 || i + repeat > nLiterals + nDistances)
+            return false;
+
+        while (repeat--)
+            lengths[i++] = length;
+    }
+
+    // The end-of-block code is mandatory
+    if (lengths[256] == 0)
+        return false;
+
+    Huffman literals;
+    Huffman distances;
+    if (!buildHuffman(literals, lengths, nLiterals)
+        || !buildHuffman(distances, lengths + nLiterals, nDistances)) {
+        return false;
+    }
+
+    return inflateCodes(in, literals, distances, out, maxSize);
+}
+
+} // namespace
+
+bool rawInflate(const char *data, int size, QByteArray &out, int maxSize)
+{
+    BitReader in(data, size);
+
+    while (!in.atEnd()) {
+        int final = in.bits(1);
+        int type = in.bits(2);
+        if (final < 0 || type < 0)
+            return false;
+
+        bool ok;
+        switch (type) {
+        case 0:
+            ok = inflateStored(in, out, maxSize);
+            break;
+        case 1:
+            ok = inflateFixed(in, out, maxSize);
+            break;
+        case 2:
+            ok = inflateDynamic(in, out, maxSize);
+            break;
+        default:
+            ok = false;
+        }
+
+        if (!ok)
+            return false;
+
+        if (final)
+            return true;
+    }
+
+    return true;
+}
+
+} // namespace Tufao
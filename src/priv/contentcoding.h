@@ -0,0 +1,74 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_CONTENTCODING_H
+#define TUFAO_PRIV_CONTENTCODING_H
+
+#include "../headers.h"
+
+namespace Tufao {
+
+/*
+  Returns the quality (in thousandths) given to coding by the Accept-Encoding
+  header values, or -1 if the coding isn't mentioned. Unless wildcard is false,
+  codings not mentioned get the quality of "*", if present.
+ */
+int acceptedQuality(const QList<QByteArray> &acceptEncoding,
+                    const char *coding, bool wildcard = true);
+
+inline int acceptedQuality(const Headers &headers, const char *coding)
+{
+    return acceptedQuality(headers.values("Accept-Encoding"), coding);
+}
+
+/*
+  The encoders are built on top of qCompress, as Tufão only depends on Qt.
+  qCompress produces a complete zlib stream (RFC 1950) prefixed by the
+  uncompressed size, so the raw deflate data (RFC 1951) is the part between the
+  2-bytes zlib header and the 4-bytes adler32 trailer.
+ */
+Q_DECL_EXPORT QByteArray rawDeflate(const QByteArray &data);
+
+// The "deflate" content-coding, which is actually the zlib format
+Q_DECL_EXPORT QByteArray zlibCompress(const QByteArray &data);
+
+// The "gzip" content-coding (RFC 1952)
+Q_DECL_EXPORT QByteArray gzipCompress(const QByteArray &data);
+
+Q_DECL_EXPORT quint32 crc32(const QByteArray &data);
+
+/*
+  Decodes the raw deflate data (RFC 1951) in data, appending the result to out.
+  There is no inflater in Qt that can be used here (qUncompress needs the
+  adler32 trailer), so this one is a compact canonical Huffman decoder.
+
+  The bytes already present in out are used as the history for the
+  back-references, what allows the decoding of streams that share the LZ77
+  window among several chunks (as permessage-deflate does). The decoding stops
+  at the final block or at the end of the input (which must happen on a block
+  boundary).
+
+  Returns false if the data is corrupt, truncated or if out would grow beyond
+  maxSize bytes.
+ */
+Q_DECL_EXPORT bool rawInflate(const char *data, int size, QByteArray &out,
+                              int maxSize);
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_CONTENTCODING_H
@@ -0,0 +1,248 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "httpdate.h"
+#include "../headers.h"
+
+#include <QtCore/QThreadStorage>
+
+#include <cstring>
+
+namespace Tufao {
+
+struct CachedHttpDate
+{
+    CachedHttpDate() :
+        second(-1)
+    {}
+
+    qint64 second;
+    QByteArray value;
+};
+
+static QThreadStorage<CachedHttpDate> cachedHttpDate;
+
+QByteArray currentHttpDate()
+{
+    CachedHttpDate &date = cachedHttpDate.localData();
+    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    if (now != date.second) {
+        date.second = now;
+        date.value = Headers::fromDateTime(QDateTime
+                                           ::fromMSecsSinceEpoch(now * 1000));
+    }
+
+    return date.value;
+}
+
+// HTTP-date is case sensitive and MUST NOT include additional LWS beyond that
+// specifically included as SP in the grammar
+
+//   HTTP-date    = rfc1123-date | rfc850-date | asctime-date
+//   rfc1123-date = wkday "," SP date1 SP time SP "GMT"
+//   rfc850-date  = weekday "," SP date2 SP time SP "GMT"
+//   asctime-date = wkday SP date3 SP time SP 4DIGIT
+//   date1        = 2DIGIT SP month SP 4DIGIT
+//   date2        = 2DIGIT "-" month "-" 2DIGIT
+//   date3        = month SP ( 2DIGIT | ( SP 1DIGIT ))
+//   time         = 2DIGIT ":" 2DIGIT ":" 2DIGIT
+
+static inline bool isAlpha(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool skip(const char *&i, const char *end, char c)
+{
+    if (i == end || *i != c)
+        return false;
+
+    ++i;
+    return true;
+}
+
+static inline bool readDigits(const char *&i, const char *end, int n,
+                              int &value)
+{
+    if (end - i < n)
+        return false;
+
+    value = 0;
+    for (const char *last = i + n;i != last;++i) {
+        if (!isDigit(*i))
+            return false;
+
+        value = value * 10 + (*i - '0');
+    }
+
+    return true;
+}
+
+#define TUFAO_MONTH_KEY(a, b, c) (quint32(a) << 16 | quint32(b) << 8 \
+                                  | quint32(c))
+
+static inline bool readMonth(const char *&i, const char *end, int &month)
+{
+    if (end - i < 3)
+        return false;
+
+    switch (TUFAO_MONTH_KEY(uchar(i[0]), uchar(i[1]), uchar(i[2]))) {
+    case TUFAO_MONTH_KEY('J', 'a', 'n'): month = 1; break;
+    case TUFAO_MONTH_KEY('F', 'e', 'b'): month = 2; break;
+    case TUFAO_MONTH_KEY('M', 'a', 'r'): month = 3; break;
+    case TUFAO_MONTH_KEY('A', 'p', 'r'): month = 4; break;
+    case TUFAO_MONTH_KEY('M', 'a', 'y'): month = 5; break;
+    case TUFAO_MONTH_KEY('J', 'u', 'n'): month = 6; break;
+    case TUFAO_MONTH_KEY('J', 'u', 'l'): month = 7; break;
+    case TUFAO_MONTH_KEY('A', 'u', 'g'): month = 8; break;
+    case TUFAO_MONTH_KEY('S', 'e', 'p'): month = 9; break;
+    case TUFAO_MONTH_KEY('O', 'c', 't'): month = 10; break;
+    case TUFAO_MONTH_KEY('N', 'o', 'v'): month = 11; break;
+    case TUFAO_MONTH_KEY('D', 'e', 'c'): month = 12; break;
+    default:
+        return false;
+    }
+
+    i += 3;
+    return true;
+}
+
+#undef TUFAO_MONTH_KEY
+
+static inline bool readTime(const char *&i, const char *end, int &hours,
+                            int &minutes, int &seconds)
+{
+    return readDigits(i, end, 2, hours) && skip(i, end, ':')
+        && readDigits(i, end, 2, minutes) && skip(i, end, ':')
+        && readDigits(i, end, 2, seconds)
+        && hours < 24 && minutes < 60 && seconds < 60;
+}
+
+static inline bool readGmt(const char *&i, const char *end)
+{
+    static const char gmt[] = " GMT";
+
+    if (end - i < int(sizeof(gmt) - 1)
+        || std::memcmp(i, gmt, sizeof(gmt) - 1) != 0) {
+        return false;
+    }
+
+    i += sizeof(gmt) - 1;
+    return true;
+}
+
+static inline bool isValidDate(int year, int month, int day)
+{
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    if (day < 1)
+        return false;
+
+    if (month == 2
+        && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) {
+        return day <= 29;
+    }
+
+    return day <= days[month - 1];
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar
+static inline qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - era * 400;
+    const int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5
+        + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100
+        + dayOfYear;
+
+    return qint64(era) * 146097 + dayOfEra - 719468;
+}
+
+bool parseHttpDate(const char *begin, const char *end, qint64 &timestamp)
+{
+    const char *i = begin;
+    while (i != end && isAlpha(*i))
+        ++i;
+
+    const int weekdaySize = i - begin;
+    int year, month, day, hours, minutes, seconds;
+
+    if (weekdaySize == 3 && skip(i, end, ',')) {
+        // Example: Sun, 06 Nov 1994 08:49:37 GMT
+        if (!skip(i, end, ' ') || !readDigits(i, end, 2, day)
+            || !skip(i, end, ' ') || !readMonth(i, end, month)
+            || !skip(i, end, ' ') || !readDigits(i, end, 4, year)
+            || !skip(i, end, ' ')
+            || !readTime(i, end, hours, minutes, seconds)
+            || !readGmt(i, end)) {
+            return false;
+        }
+    } else if (weekdaySize > 3 && skip(i, end, ',')) {
+        // Example: Sunday, 06-Nov-94 08:49:37 GMT
+        if (!skip(i, end, ' ') || !readDigits(i, end, 2, day)
+            || !skip(i, end, '-') || !readMonth(i, end, month)
+            || !skip(i, end, '-') || !readDigits(i, end, 2, year)
+            || !skip(i, end, ' ')
+            || !readTime(i, end, hours, minutes, seconds)
+            || !readGmt(i, end)) {
+            return false;
+        }
+
+        year += 1900;
+    } else if (weekdaySize == 3 && skip(i, end, ' ')) {
+        // Example: Sun Nov  6 08:49:37 1994
+        //
+        // A two digit day or a single digit one preceded by zero or one extra
+        // SP are accepted, as Tufão always did
+        if (!readMonth(i, end, month) || !skip(i, end, ' '))
+            return false;
+
+        if (!skip(i, end, ' ') && i != end && isDigit(*i)
+            && i + 1 != end && isDigit(i[1])) {
+            if (!readDigits(i, end, 2, day))
+                return false;
+        } else if (!readDigits(i, end, 1, day)) {
+            return false;
+        }
+
+        if (!skip(i, end, ' ')
+            || !readTime(i, end, hours, minutes, seconds)
+            || !skip(i, end, ' ') || !readDigits(i, end, 4, year)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    if (i != end || !isValidDate(year, month, day))
+        return false;
+
+    timestamp = daysFromCivil(year, month, day) * 86400
+        + hours * 3600 + minutes * 60 + seconds;
+    return true;
+}
+
+} // namespace Tufao
@@ -0,0 +1,53 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_HTTPDATE_H
+#define TUFAO_PRIV_HTTPDATE_H
+
+#include <QtCore/QByteArray>
+
+namespace Tufao {
+
+/*
+  Returns the current date formatted as a HTTP-date (RFC 1123).
+
+  The value is cached per thread and regenerated at most once per second, so
+  it's cheap enough to be called for every response.
+ */
+QByteArray currentHttpDate();
+
+/*
+  Parses a HTTP-date in any of the three formats allowed by RFC 2616's 3.3.1
+  (RFC 1123, RFC 850 and ANSI C's asctime()) and stores the result in
+  timestamp as seconds since the UNIX epoch.
+
+  The input is scanned once and no memory is allocated. Returns false if the
+  input isn't a valid HTTP-date, leaving timestamp untouched.
+ */
+Q_DECL_EXPORT bool parseHttpDate(const char *begin, const char *end,
+                                qint64 &timestamp);
+
+inline bool parseHttpDate(const QByteArray &value, qint64 &timestamp)
+{
+    return parseHttpDate(value.constData(), value.constData() + value.size(),
+                         timestamp);
+}
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_HTTPDATE_H
@@ -0,0 +1,116 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "httpfilecache.h"
+#include "../headers.h"
+
+#include <QtCore/QFile>
+
+#include <limits>
+
+namespace Tufao {
+
+HttpFileCache::HttpFileCache() :
+    cache(0),
+    maxFileSize_(64 * 1024)
+{
+}
+
+qint64 HttpFileCache::maxSize() const
+{
+    QMutexLocker locker(&mutex);
+    return cache.maxCost();
+}
+
+void HttpFileCache::setMaxSize(qint64 size)
+{
+    // QCache counts the cost with an int
+    size = qBound(qint64(0), size, qint64(std::numeric_limits<int>::max()));
+
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(size);
+}
+
+qint64 HttpFileCache::maxFileSize() const
+{
+    QMutexLocker locker(&mutex);
+    return maxFileSize_;
+}
+
+void HttpFileCache::setMaxFileSize(qint64 size)
+{
+    QMutexLocker locker(&mutex);
+    maxFileSize_ = size;
+}
+
+bool HttpFileCache::get(const QFileInfo &fileInfo, Entry &entry)
+{
+    const QString key = fileInfo.absoluteFilePath();
+    const qint64 size = fileInfo.size();
+    const QDateTime modificationTime = fileInfo.lastModified();
+
+    {
+        QMutexLocker locker(&mutex);
+
+        if (!cache.maxCost() || size > maxFileSize_ || size > cache.maxCost())
+            return false;
+
+        if (Entry *cached = cache.object(key)) {
+            if (cached->size == size
+                && cached->modificationTime == modificationTime) {
+                entry = *cached;
+                return true;
+            }
+
+            cache.remove(key);
+        }
+    }
+
+    // The file is read without holding the lock
+    QFile file(key);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    Entry *loaded = new Entry;
+    loaded->contents = file.readAll();
+
+    // The file changed while it was read
+    if (loaded->contents.size() != size) {
+        delete loaded;
+        return false;
+    }
+
+    loaded->mimeType = mimes.mimeTypeForFile(fileInfo).name().toUtf8();
+    loaded->lastModified = Headers::fromDateTime(modificationTime);
+    loaded->etag = fileETag(size, modificationTime);
+    loaded->modificationTime = modificationTime;
+    loaded->size = size;
+    entry = *loaded;
+
+    QMutexLocker locker(&mutex);
+    cache.insert(key, loaded, size);
+    return true;
+}
+
+QByteArray fileETag(qint64 size, const QDateTime &modificationTime)
+{
+    return '"' + QByteArray::number(modificationTime.toMSecsSinceEpoch(), 16)
+        + '-' + QByteArray::number(size, 16) + '"';
+}
+
+} // namespace Tufao
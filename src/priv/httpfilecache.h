@@ -0,0 +1,84 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_HTTPFILECACHE_H
+#define TUFAO_PRIV_HTTPFILECACHE_H
+
+#include <QtCore/QCache>
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMimeDatabase>
+#include <QtCore/QMutex>
+
+namespace Tufao {
+
+/*
+  A LRU cache of small files used by HttpFileServer, bounded by the total size
+  of the cached contents.
+
+  Entries are keyed by the absolute path of the file and revalidated against
+  the size and modification time reported by the QFileInfo given to get(), so
+  a file changed on disk is reloaded on the next request. The cache is
+  thread-safe.
+ */
+class Q_DECL_EXPORT HttpFileCache
+{
+public:
+    struct Entry
+    {
+        QByteArray contents;
+        QByteArray mimeType;
+        QByteArray lastModified;
+        QByteArray etag;
+        QDateTime modificationTime;
+        qint64 size;
+    };
+
+    HttpFileCache();
+
+    qint64 maxSize() const;
+    void setMaxSize(qint64 size);
+
+    qint64 maxFileSize() const;
+    void setMaxFileSize(qint64 size);
+
+    /*
+      Fills entry with the cached data for fileInfo, loading the file if it
+      isn't cached yet or changed since it was cached.
+
+      Returns false if the cache is disabled, the file is too large to be
+      cached or it can't be read.
+     */
+    bool get(const QFileInfo &fileInfo, Entry &entry);
+
+private:
+    mutable QMutex mutex;
+    QCache<QString, Entry> cache;
+    qint64 maxFileSize_;
+    QMimeDatabase mimes;
+};
+
+/*
+  Returns a strong entity tag derived from the size and modification time of a
+  file.
+ */
+QByteArray fileETag(qint64 size, const QDateTime &modificationTime);
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_HTTPFILECACHE_H
@@ -0,0 +1,187 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "httpfilestreamer.h"
+#include "../httpfileserver.h"
+
+#include <QtNetwork/QAbstractSocket>
+
+#include <limits>
+
+namespace Tufao {
+
+HttpFileStreamer::HttpFileStreamer(const QString &fileName,
+                                   HttpServerResponse &response,
+                                   QAbstractSocket *socket) :
+    QObject(&response),
+    file(fileName),
+    data(0),
+    response(response),
+    socket(socket),
+    current(0),
+    window(0),
+    writing(false)
+{
+}
+
+HttpFileStreamer::HttpFileStreamer(const QByteArray &contents,
+                                   HttpServerResponse &response,
+                                   QAbstractSocket *socket) :
+    QObject(&response),
+    contents(contents),
+    data(this->contents.constData()),
+    response(response),
+    socket(socket),
+    current(0),
+    window(0),
+    writing(false)
+{
+}
+
+bool HttpFileStreamer::open()
+{
+    if (data)
+        return true;
+
+    // Reads already go to a buffer sized by the window
+    return file.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void HttpFileStreamer::append(const QByteArray &data)
+{
+    Part part;
+    part.data = data;
+    part.offset = 0;
+    part.length = 0;
+    parts.push_back(part);
+}
+
+void HttpFileStreamer::append(qint64 offset, qint64 length)
+{
+    Part part;
+    part.offset = offset;
+    part.length = length;
+    parts.push_back(part);
+}
+
+void HttpFileStreamer::start(qint64 window, const QByteArray &tail)
+{
+    this->tail = tail;
+
+    if (window <= 0 || !socket) {
+        this->window = std::numeric_limits<qint64>::max();
+        onBytesWritten();
+        return;
+    }
+
+    this->window = window;
+    connect(socket, &QIODevice::bytesWritten,
+            this, &HttpFileStreamer::onBytesWritten);
+    onBytesWritten();
+}
+
+void HttpFileStreamer::onBytesWritten()
+{
+    // The response may flush the socket (e.g. in end), which emits
+    // bytesWritten while the parts are being written
+    if (writing)
+        return;
+
+    writing = true;
+    while (current != parts.size()) {
+        if (socket && !socket->isOpen()) {
+            deleteLater();
+            return;
+        }
+
+        qint64 queued = socket ? socket->bytesToWrite() : 0;
+        if (queued >= window) {
+            writing = false;
+            return;
+        }
+
+        Part &part = parts[current];
+        if (!writeSome(part, window - queued)) {
+            if (socket)
+                socket->close();
+            deleteLater();
+            return;
+        }
+
+        if (part.data.isEmpty() && !part.length)
+            ++current;
+    }
+
+    finish();
+}
+
+inline bool HttpFileStreamer::writeSome(Part &part, qint64 maxSize)
+{
+    if (!part.data.isEmpty()) {
+        response << part.data;
+        part.data.clear();
+        return true;
+    }
+
+    if (!part.length)
+        return true;
+
+    if (data) {
+        qint64 size = qMin(part.length, maxSize);
+        response << QByteArray::fromRawData(data + part.offset, size);
+        part.offset += size;
+        part.length -= size;
+        return true;
+    }
+
+    if (file.pos() != part.offset && !file.seek(part.offset))
+        return false;
+
+    // Files aren't mapped in memory, because a file truncated while it's
+    // served would raise SIGBUS on the next access. The response copies the
+    // bytes, so the buffer is reused by the next read.
+    qint64 size = qMin(qMin(part.length, maxSize),
+                       qMin(HttpFileServer::bufferSize(),
+                            qint64(std::numeric_limits<int>::max())));
+    buffer.resize(int(size));
+    qint64 read = file.read(buffer.data(), size);
+
+    // A file truncated while it's served ends the response prematurely
+    if (read <= 0)
+        return false;
+
+    // The bytes stay queued in the socket, the window drives the next writes
+    buffer.resize(int(read));
+    part.offset += read;
+    part.length -= read;
+    response << buffer;
+    return true;
+}
+
+inline void HttpFileStreamer::finish()
+{
+    if (socket) {
+        disconnect(socket, &QIODevice::bytesWritten,
+                   this, &HttpFileStreamer::onBytesWritten);
+    }
+
+    response.end(tail);
+    deleteLater();
+}
+
+} // namespace Tufao
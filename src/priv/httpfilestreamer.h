@@ -0,0 +1,111 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_HTTPFILESTREAMER_H
+#define TUFAO_PRIV_HTTPFILESTREAMER_H
+
+#include "../httpserverresponse.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QVector>
+
+class QAbstractSocket;
+
+namespace Tufao {
+
+/*
+  Sends a sequence of file ranges (and the raw bytes between them) as the body
+  of a response whose head was already written.
+
+  In the streaming mode, data is only queued while the socket has less than
+  window bytes waiting to be written, and the remaining parts are sent as the
+  socket's bytesWritten signal fires, so a slow client can't stall the event
+  loop nor pile the whole file in memory. The streamer finishes the response
+  and schedules its own deletion when done.
+
+  Contents cached in memory are used as is. Files are read in chunks of at most
+  HttpFileServer::bufferSize bytes, also bounded by the window, so a file
+  truncated while it's served only ends the response.
+ */
+class HttpFileStreamer : public QObject
+{
+    Q_OBJECT
+public:
+    HttpFileStreamer(const QString &fileName, HttpServerResponse &response,
+                     QAbstractSocket *socket);
+
+    // Streams from contents instead of a file
+    HttpFileStreamer(const QByteArray &contents, HttpServerResponse &response,
+                     QAbstractSocket *socket);
+
+    bool open();
+    qint64 size() const;
+
+    void append(const QByteArray &data);
+    void append(qint64 offset, qint64 length);
+
+    /*
+      Starts sending the queued parts and finishes the response with \p tail.
+
+      If \p window is zero or there is no socket, everything is written
+      before this function returns.
+     */
+    void start(qint64 window, const QByteArray &tail = QByteArray());
+
+private slots:
+    void onBytesWritten();
+
+private:
+    struct Part
+    {
+        QByteArray data;
+        qint64 offset;
+        qint64 length;
+    };
+
+    // Returns false on read errors
+    bool writeSome(Part &part, qint64 maxSize);
+    void finish();
+
+    QFile file;
+    QByteArray contents;
+
+    // Points to contents when streaming from memory
+    const char *data;
+
+    // Reused by the reads of the file
+    QByteArray buffer;
+    HttpServerResponse &response;
+    QAbstractSocket *socket;
+    QVector<Part> parts;
+    int current;
+    qint64 window;
+    QByteArray tail;
+
+    // Set while onBytesWritten runs, so it isn't re-entered
+    bool writing;
+};
+
+inline qint64 HttpFileStreamer::size() const
+{
+    return file.isOpen() ? file.size() : contents.size();
+}
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_HTTPFILESTREAMER_H
@@ -23,16 +23,30 @@
 #include "../httpserverrequest.h"
 #include "tcpserverwrapper.h"
 
+#include <QtCore/QVector>
+
+class QThread;
+
 namespace Tufao {
 
+class HttpServerWorker;
+
 struct HttpServer::Priv
 {
     Priv();
 
     TcpServerWrapper tcpServer;
     int timeout;
+    qint64 maxBodySize;
     UpgradeHandler upgradeHandler;
 
+    // Multi-threaded mode
+    int workerThreads;
+    HandlerFactory handlerFactory;
+    QVector<QThread*> threads;
+    QVector<HttpServerWorker*> workers;
+    int nextWorker;
+
     static UpgradeHandler defaultUpgradeHandler;
 };
 
@@ -44,7 +58,10 @@ HttpServer::UpgradeHandler HttpServer::Priv::defaultUpgradeHandler{
 
 inline HttpServer::Priv::Priv() :
     timeout(120000),
-    upgradeHandler(defaultUpgradeHandler)
+    maxBodySize(0),
+    upgradeHandler(defaultUpgradeHandler),
+    workerThreads(0),
+    nextWorker(0)
 {}
 
 } // namespace Tufao
@@ -22,7 +22,9 @@
 #include <boost/http/reader/request.hpp>
 
 #include "../headers.h"
+#include "../flatheaders.h"
 #include "../httpserverrequest.h"
+#include "../routeparameters.h"
 
 #include <QtNetwork/QAbstractSocket>
 #include <QtCore/QTimer>
@@ -44,30 +46,78 @@ struct HttpServerRequest::Priv
     };
     Q_DECLARE_FLAGS(Signals, Signal)
 
+    // Initial capacity of the receive buffer
+    static const int BUFFER_CAPACITY = 4096;
+
     Priv(QAbstractSocket &socket) :
         socket(socket),
+        bufferOffset(0),
+        bodySize(0),
+        headersBuilt(false),
         responseOptions(0),
-        timeout(0)
+        timeout(0),
+        maxBodySize(0),
+        highWatermark(0),
+        lowWatermark(0),
+        paused(false),
+        customDataArgs(0)
     {
+        buffer.reserve(BUFFER_CAPACITY);
         timer.setSingleShot(true);
     }
 
     QAbstractSocket &socket;
+
+    // Bytes before bufferOffset were already consumed by the parser. They are
+    // only discarded when the buffer needs room, so the parser works in place
+    // and we don't pay a memmove per read.
     QByteArray buffer;
+    int bufferOffset;
+
     reader::request parser;
     QByteArray lastHeader;
     QByteArray body;
 
+    // Bytes of body received in the current request
+    qint64 bodySize;
+
     QByteArray method;
     QUrl url;
     Tufao::HttpVersion httpVersion;
+
+    // The headers are parsed into flatHeaders and the Headers object is only
+    // built when the user asks for it
+    FlatHeaders flatHeaders;
     Headers headers;
+    bool headersBuilt;
+
     Headers trailers;
     Tufao::HttpServerResponse::Options responseOptions;
     QVariant customData;
 
     int timeout;
     QTimer timer;
+
+    qint64 maxBodySize;
+
+    // Streaming body mode
+    qint64 highWatermark;
+    qint64 lowWatermark;
+    bool paused;
+
+    RouteParameters routeParameters;
+
+    Headers &builtHeaders()
+    {
+        if (!headersBuilt) {
+            headers = flatHeaders.toHeaders();
+            headersBuilt = true;
+        }
+        return headers;
+    }
+
+    // The route parameters already present in the "args" item of customData
+    int customDataArgs;
 };
 
 } // namespace Tufao
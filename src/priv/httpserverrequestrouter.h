@@ -20,7 +20,11 @@
 #define TUFAO_PRIV_HTTPSERVERREQUESTROUTER_H
 
 #include "../httpserverrequestrouter.h"
+#include "routetable.h"
 
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
 #include <QtCore/QVector>
 
 namespace Tufao {
@@ -31,7 +35,36 @@ class AbstractHttpServerRequestHandler;
 
 struct HttpServerRequestRouter::Priv
 {
+    typedef QPair<QByteArray, QString> CacheKey;
+    typedef RouteTable::Matches Matches;
+
+    Priv() :
+        cache(DEFAULT_CACHE_SIZE)
+    {}
+    Priv(std::initializer_list<Mapping> mappings) :
+        mappings(mappings),
+        cache(DEFAULT_CACHE_SIZE)
+    {}
+
+    // Recompiles the routes after the mappings changed
+    void update();
+
+    // Returns the mappings matching the request, ordered by index
+    Matches lookup(const QByteArray &method, const QString &path);
+
+    static const int DEFAULT_CACHE_SIZE = 1024;
+
     QVector<Mapping> mappings;
+    // QRegularExpression::namedCaptureGroups of each mapping
+    QVector<QStringList> captureNames;
+
+    // The routes of the mappings accepting each method
+    QHash<QByteArray, RouteTable> buckets;
+    // Used for the methods not named by any mapping
+    RouteTable anyMethod;
+
+    QCache<CacheKey, Matches> cache;
+    bool dirty = true;
 };
 
 } // namespace Tufao
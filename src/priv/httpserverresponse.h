@@ -40,7 +40,8 @@ struct HttpServerResponse::Priv
     Priv(QIODevice &device, Tufao::HttpServerResponse::Options options) :
         device(device),
         formattingState(STATUS_LINE),
-        options(options)
+        options(options),
+        chunked(true)
     {}
 
     QIODevice &device;
@@ -48,6 +49,18 @@ struct HttpServerResponse::Priv
     Tufao::HttpServerResponse::Options options;
     Headers headers;
 
+    // The status line and headers are accumulated here and sent together with
+    // the first piece of body in a single write
+    QByteArray head;
+
+    // False when the user provided a Content-Length and the body is sent as is
+    bool chunked;
+
+    // The content-coding chosen by enableCompression and the body buffered to
+    // be compressed at once
+    QByteArray contentCoding;
+    QByteArray uncompressedBody;
+
     QByteArray http10Buffer;
 };
 
@@ -0,0 +1,110 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "httpserverworker.h"
+#include "../httpserverrequest.h"
+#include "../headers.h"
+#include "../flatheaders.h"
+
+#include <QtNetwork/QAbstractSocket>
+
+namespace Tufao {
+
+HttpServerWorker::HttpServerWorker(HttpServer::HandlerFactory factory,
+                                   int timeout, qint64 maxBodySize,
+                                   HttpServer::UpgradeHandler upgradeHandler) :
+    factory(factory),
+    timeout(timeout),
+    maxBodySize(maxBodySize),
+    upgradeHandler(upgradeHandler)
+{
+    qRegisterMetaType<QAbstractSocket*>("QAbstractSocket*");
+
+    connect(this, &HttpServerWorker::newConnection,
+            this, &HttpServerWorker::onNewConnection, Qt::QueuedConnection);
+}
+
+void HttpServerWorker::addConnection(QAbstractSocket *socket)
+{
+    emit newConnection(socket);
+}
+
+void HttpServerWorker::onNewConnection(QAbstractSocket *socket)
+{
+    // The handler is created lazily to ensure it'll live in the worker thread
+    if (!handler)
+        handler = factory();
+
+    socket->setParent(this);
+    HttpServerRequest *handle = new HttpServerRequest(*socket, this);
+
+    if (timeout)
+        handle->setTimeout(timeout);
+
+    if (maxBodySize)
+        handle->setMaxBodySize(maxBodySize);
+
+    connect(handle, &HttpServerRequest::ready,
+            this, &HttpServerWorker::onRequestReady);
+    connect(handle, &HttpServerRequest::upgrade,
+            this, &HttpServerWorker::onUpgrade);
+    connect(socket, &QAbstractSocket::disconnected,
+            handle, &QObject::deleteLater);
+    connect(socket, &QAbstractSocket::disconnected,
+            socket, &QObject::deleteLater);
+
+    // Some bytes may have arrived while the socket was being moved
+    if (socket->bytesAvailable())
+        QMetaObject::invokeMethod(socket, "readyRead", Qt::QueuedConnection);
+}
+
+void HttpServerWorker::onRequestReady()
+{
+    HttpServerRequest *request = qobject_cast<HttpServerRequest *>(sender());
+    Q_ASSERT(request);
+
+    QAbstractSocket &socket = request->socket();
+    HttpServerResponse *response
+            = new HttpServerResponse(socket, request->responseOptions(), this);
+
+    connect(&socket, &QAbstractSocket::disconnected,
+            response, &QObject::deleteLater);
+    connect(response, &HttpServerResponse::finished,
+            request, &HttpServerRequest::resume);
+    connect(response, &HttpServerResponse::finished,
+            response, &QObject::deleteLater);
+
+    if (request->flatHeaders().values("Expect").contains("100-continue"))
+        response->writeContinue();
+
+    if (!handler(*request, *response)) {
+        response->writeHead(HttpResponseStatus::NOT_FOUND);
+        response->end();
+    }
+}
+
+void HttpServerWorker::onUpgrade()
+{
+    HttpServerRequest *request = qobject_cast<HttpServerRequest *>(sender());
+    Q_ASSERT(request);
+
+    upgradeHandler(*request, request->readBody());
+    delete request;
+}
+
+} // namespace Tufao
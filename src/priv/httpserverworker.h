@@ -0,0 +1,64 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_HTTPSERVERWORKER_H
+#define TUFAO_PRIV_HTTPSERVERWORKER_H
+
+#include "../httpserver.h"
+
+class QAbstractSocket;
+
+namespace Tufao {
+
+/*
+  A HttpServerWorker lives in its own thread and serves the connections handed
+  off by HttpServer in the multi-threaded mode.
+ */
+class HttpServerWorker : public QObject
+{
+    Q_OBJECT
+public:
+    HttpServerWorker(HttpServer::HandlerFactory factory, int timeout,
+                     qint64 maxBodySize,
+                     HttpServer::UpgradeHandler upgradeHandler);
+
+    /*
+      Thread-safe. The \p socket MUST already live in the worker's thread and
+      have no parent.
+     */
+    void addConnection(QAbstractSocket *socket);
+
+signals:
+    void newConnection(QAbstractSocket *socket);
+
+private slots:
+    void onNewConnection(QAbstractSocket *socket);
+    void onRequestReady();
+    void onUpgrade();
+
+private:
+    HttpServer::HandlerFactory factory;
+    HttpServer::Handler handler;
+    int timeout;
+    qint64 maxBodySize;
+    HttpServer::UpgradeHandler upgradeHandler;
+};
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_HTTPSERVERWORKER_H
@@ -20,14 +20,41 @@
 #define TUFAO_PRIV_HTTPUPGRADEROUTER_H
 
 #include "../httpupgraderouter.h"
+#include "routetable.h"
 
+#include <QtCore/QCache>
 #include <QtCore/QVector>
 
 namespace Tufao {
 
 struct HttpUpgradeRouter::Priv
 {
+    typedef RouteTable::Matches Matches;
+
+    Priv() :
+        cache(DEFAULT_CACHE_SIZE)
+    {}
+    Priv(std::initializer_list<Mapping> mappings) :
+        mappings(mappings),
+        cache(DEFAULT_CACHE_SIZE)
+    {}
+
+    // Recompiles the routes after the mappings changed
+    void update();
+
+    // Returns the mappings matching path, ordered by index
+    Matches lookup(const QString &path);
+
+    static const int DEFAULT_CACHE_SIZE = 1024;
+
     QVector<Mapping> mappings;
+    // QRegularExpression::namedCaptureGroups of each mapping
+    QVector<QStringList> captureNames;
+
+    RouteTable routes;
+
+    QCache<QString, Matches> cache;
+    bool dirty = true;
 };
 
 } // namespace Tufao
@@ -0,0 +1,317 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "permessagedeflate.h"
+#include "contentcoding.h"
+
+namespace Tufao {
+
+// zlib can't compress using 8 bits windows (it silently uses 9 bits)
+static const int MIN_WINDOW_BITS = 9;
+static const int MAX_WINDOW_BITS = 15;
+
+// Smaller messages rarely get smaller
+static const int MIN_COMPRESSED_SIZE = 64;
+
+// Limits the memory a malicious peer can make us allocate (a "zip bomb")
+static const int MAX_INFLATED_SIZE = 64 * 1024 * 1024;
+
+namespace {
+
+struct Parameters
+{
+    Parameters() :
+        serverNoContextTakeover(false),
+        clientNoContextTakeover(false),
+        serverMaxWindowBits(0),
+        clientMaxWindowBits(0)
+    {}
+
+    bool serverNoContextTakeover;
+    bool clientNoContextTakeover;
+    // 0 if absent
+    int serverMaxWindowBits;
+    // 0 if absent and -1 if present without a value
+    int clientMaxWindowBits;
+};
+
+// Returns 0 if value isn't a valid number of bits
+int parseWindowBits(const QByteArray &value)
+{
+    if (value.isEmpty() || value.size() > 2)
+        return 0;
+
+    for (int i = 0;i != value.size();++i) {
+        if (value[i] < '0' || value[i] > '9')
+            return 0;
+    }
+
+    int bits = value.toInt();
+    return (bits >= 8 && bits <= MAX_WINDOW_BITS) ? bits : 0;
+}
+
+// Returns false if element isn't a valid permessage-deflate element
+bool parseElement(const QByteArray &element, Parameters &parameters)
+{
+    QList<QByteArray> tokens = element.split(';');
+    if (tokens[0].trimmed() != "permessage-deflate")
+        return false;
+
+    for (int i = 1;i != tokens.size();++i) {
+        QByteArray token = tokens[i].trimmed();
+        int separator = token.indexOf('=');
+        QByteArray name = token.left(separator).trimmed();
+        bool hasValue = separator != -1;
+        QByteArray value;
+
+        if (hasValue) {
+            value = token.mid(separator + 1).trimmed();
+            if (value.size() >= 2 && value.startsWith('"')
+                && value.endsWith('"')) {
+                value = value.mid(1, value.size() - 2);
+            }
+        }
+
+        if (name == "server_no_context_takeover") {
+            if (hasValue || parameters.serverNoContextTakeover)
+                return false;
+
+            parameters.serverNoContextTakeover = true;
+        } else if (name == "client_no_context_takeover") {
+            if (hasValue || parameters.clientNoContextTakeover)
+                return false;
+
+            parameters.clientNoContextTakeover = true;
+        } else if (name == "server_max_window_bits") {
+            if (!hasValue || parameters.serverMaxWindowBits)
+                return false;
+
+            parameters.serverMaxWindowBits = parseWindowBits(value);
+            if (!parameters.serverMaxWindowBits)
+                return false;
+        } else if (name == "client_max_window_bits") {
+            if (parameters.clientMaxWindowBits)
+                return false;
+
+            parameters.clientMaxWindowBits
+                = hasValue ? parseWindowBits(value) : -1;
+            if (!parameters.clientMaxWindowBits)
+                return false;
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The biggest window that fits in memoryLimit, or 0 if none does
+int windowBitsFor(int memoryLimit)
+{
+    int bits = MAX_WINDOW_BITS;
+    while (bits >= MIN_WINDOW_BITS && (1 << bits) > memoryLimit)
+        --bits;
+
+    return bits >= MIN_WINDOW_BITS ? bits : 0;
+}
+
+} // namespace
+
+PerMessageDeflate::PerMessageDeflate() :
+    enabled(false),
+    memoryLimit(1 << MAX_WINDOW_BITS)
+{
+    reset();
+}
+
+void PerMessageDeflate::reset()
+{
+    active = false;
+    offered = false;
+    windowBits = MAX_WINDOW_BITS;
+    peerWindowBits = MAX_WINDOW_BITS;
+    peerNoContextTakeover = false;
+    compressedMessage = false;
+    history.clear();
+}
+
+QByteArray PerMessageDeflate::negotiate(const FlatHeaders &requestHeaders)
+{
+    reset();
+
+    if (!enabled)
+        return QByteArray();
+
+    foreach (const QByteArray &value,
+             requestHeaders.values("Sec-WebSocket-Extensions")) {
+        foreach (const QByteArray &element, value.split(',')) {
+            Parameters offer;
+            if (!parseElement(element, offer))
+                continue;
+
+            QByteArray response("permessage-deflate;"
+                                " server_no_context_takeover");
+
+            if (offer.serverMaxWindowBits) {
+                windowBits = offer.serverMaxWindowBits;
+                response += "; server_max_window_bits="
+                    + QByteArray::number(windowBits);
+            }
+
+            int bits = windowBitsFor(memoryLimit);
+            if (offer.clientMaxWindowBits > 0)
+                bits = qMin(bits, offer.clientMaxWindowBits);
+
+            // A peer that didn't offer client_max_window_bits can only be
+            // limited by not keeping any window
+            if (bits < MAX_WINDOW_BITS && !offer.clientMaxWindowBits)
+                bits = 0;
+
+            if (offer.clientNoContextTakeover || !bits) {
+                peerNoContextTakeover = true;
+                response += "; client_no_context_takeover";
+            } else {
+                peerWindowBits = bits;
+                if (bits < MAX_WINDOW_BITS) {
+                    response += "; client_max_window_bits="
+                        + QByteArray::number(bits);
+                }
+            }
+
+            active = true;
+            return response;
+        }
+    }
+
+    return QByteArray();
+}
+
+QByteArray PerMessageDeflate::offer()
+{
+    reset();
+    offered = true;
+
+    QByteArray value("permessage-deflate; client_no_context_takeover;"
+                     " client_max_window_bits");
+
+    int bits = windowBitsFor(memoryLimit);
+    if (!bits) {
+        value += "; server_no_context_takeover";
+    } else if (bits < MAX_WINDOW_BITS) {
+        value += "; server_max_window_bits=" + QByteArray::number(bits);
+    }
+
+    return value;
+}
+
+bool PerMessageDeflate::acceptResponse(const QList<QByteArray> &values)
+{
+    if (values.isEmpty())
+        return true;
+
+    if (!offered)
+        return false;
+
+    QList<QByteArray> elements;
+    foreach (const QByteArray &value, values)
+        elements += value.split(',');
+
+    Parameters response;
+    if (elements.size() != 1 || !parseElement(elements[0], response)
+        || response.clientMaxWindowBits < 0) {
+        return false;
+    }
+
+    // The server must honour the window we asked for
+    int bits = windowBitsFor(memoryLimit);
+    if (!response.serverNoContextTakeover
+        && (!bits || (bits < MAX_WINDOW_BITS
+                      && (!response.serverMaxWindowBits
+                          || response.serverMaxWindowBits > bits)))) {
+        return false;
+    }
+
+    if (response.clientMaxWindowBits)
+        windowBits = response.clientMaxWindowBits;
+    if (response.serverMaxWindowBits)
+        peerWindowBits = response.serverMaxWindowBits;
+    peerNoContextTakeover = response.serverNoContextTakeover;
+    active = true;
+    return true;
+}
+
+bool PerMessageDeflate::compress(const QByteArray &message,
+                                 QByteArray &out) const
+{
+    if (!accepts(message.size()))
+        return false;
+
+    QByteArray deflated(deflate(message));
+    if (deflated.isNull())
+        return false;
+
+    out = deflated;
+    return true;
+}
+
+bool PerMessageDeflate::accepts(int size) const
+{
+    // qCompress always uses the largest window. When the peer asked for a
+    // smaller one, messages bigger than it could have back-references that
+    // the peer can't follow.
+    return active && size >= MIN_COMPRESSED_SIZE
+        && (windowBits >= MAX_WINDOW_BITS || size <= (1 << windowBits));
+}
+
+QByteArray PerMessageDeflate::deflate(const QByteArray &message)
+{
+    // The final block is followed by an empty stored block without its last 4
+    // bytes (RFC 7692, section 7.2.3.3)
+    QByteArray deflated(rawDeflate(message));
+    deflated.append('\0');
+
+    if (deflated.size() >= message.size())
+        return QByteArray();
+
+    return deflated;
+}
+
+bool PerMessageDeflate::inflate(QByteArray &message)
+{
+    static const char tail[] = {0x00, 0x00, char(0xff), char(0xff)};
+    message.append(tail, sizeof(tail));
+
+    const int historySize = history.size();
+    QByteArray out(history);
+
+    if (!rawInflate(message.constData(), message.size(), out,
+                    historySize + MAX_INFLATED_SIZE)) {
+        return false;
+    }
+
+    if (!peerNoContextTakeover)
+        history = out.right(1 << peerWindowBits);
+
+    if (historySize)
+        out.remove(0, historySize);
+
+    message = out;
+    return true;
+}
+
+} // namespace Tufao
@@ -0,0 +1,92 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_PERMESSAGEDEFLATE_H
+#define TUFAO_PRIV_PERMESSAGEDEFLATE_H
+
+#include "../headers.h"
+#include "../flatheaders.h"
+
+namespace Tufao {
+
+/*
+  The permessage-deflate extension (RFC 7692) of a WebSocket connection.
+
+  Messages sent by this endpoint are compressed independently (the compressor
+  is qCompress, which can't keep its LZ77 window between messages), so this
+  endpoint always negotiates its own side as "no_context_takeover". The window
+  of the peer is kept in history, limited by memoryLimit. If memoryLimit can't
+  hold a window of, at least, 512 bytes, the peer is asked to reset its window
+  after each message.
+ */
+struct Q_DECL_EXPORT PerMessageDeflate
+{
+    PerMessageDeflate();
+
+    // Forgets the parameters negotiated in a previous connection
+    void reset();
+
+    // Server role. Returns the value of the Sec-WebSocket-Extensions response
+    // header, or an empty value if no offer was accepted.
+    QByteArray negotiate(const FlatHeaders &requestHeaders);
+
+    // Client role. Returns the value of the Sec-WebSocket-Extensions request
+    // header.
+    QByteArray offer();
+
+    // Client role. Returns false if the values of the Sec-WebSocket-Extensions
+    // response headers are not acceptable.
+    bool acceptResponse(const QList<QByteArray> &values);
+
+    // Returns false (and leaves out untouched) if message shouldn't be sent
+    // compressed
+    bool compress(const QByteArray &message, QByteArray &out) const;
+
+    // Whether messages of size bytes should be sent compressed to the peer
+    bool accepts(int size) const;
+
+    // The payload of a compressed message, independent of the connection
+    // (this endpoint never takes over the context), or a null QByteArray if
+    // compression doesn't make message smaller
+    static QByteArray deflate(const QByteArray &message);
+
+    // Replaces the payload of a compressed message by its decompressed
+    // content. Returns false if the payload is corrupt or too big.
+    bool inflate(QByteArray &message);
+
+    // User settings
+    bool enabled;
+    int memoryLimit;
+
+    // Negotiated parameters
+    bool active;
+    bool offered;
+    int windowBits;
+    int peerWindowBits;
+    bool peerNoContextTakeover;
+
+    // Whether the message being received has the RSV1 bit set
+    bool compressedMessage;
+
+    // The last decompressed bytes, referenced by the next message of the peer
+    QByteArray history;
+};
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_PERMESSAGEDEFLATE_H
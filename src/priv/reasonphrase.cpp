@@ -18,94 +18,125 @@
 
 #include "reasonphrase.h"
 #include <QtCore/QByteArray>
-#include <map>
 
-namespace Tufao {
+// X(code, reason phrase)
+#define TUFAO_STATUS_CODES(X) \
+    /* 1xx Informational */ \
+    X(100, "Continue") \
+    X(101, "Switching Protocols") \
+    X(102, "Processing") \
+    X(103, "Checkpoint") \
+    \
+    /* 2xx Successful */ \
+    X(200, "OK") \
+    X(201, "Created") \
+    X(202, "Accepted") \
+    X(203, "Non-Authoritative Information") \
+    X(204, "No Content") \
+    X(205, "Reset Content") \
+    X(206, "Partial Content") \
+    X(207, "Multi-Status") \
+    X(208, "Already Reported") \
+    X(226, "IM Used") \
+    \
+    /* 3xx Redirection */ \
+    X(300, "Multiple Choices") \
+    X(301, "Moved Permanently") \
+    X(302, "Found") \
+    X(303, "See Other") \
+    X(304, "Not Modified") \
+    X(305, "Use Proxy") \
+    X(306, "Switch Proxy") \
+    X(307, "Temporary Redirect") \
+    X(308, "Resume Incomplete") \
+    \
+    /* 4xx Client Error */ \
+    X(400, "Bad Request") \
+    X(401, "Unauthorized") \
+    X(402, "Payment Required") \
+    X(403, "Forbidden") \
+    X(404, "Not Found") \
+    X(405, "Method Not Allowed") \
+    X(406, "Not Acceptable") \
+    X(407, "Proxy Authentication Required") \
+    X(408, "Request Timeout") \
+    X(409, "Conflict") \
+    X(410, "Gone") \
+    X(411, "Length Required") \
+    X(412, "Precondition Failed") \
+    X(413, "Request Entity Too Large") \
+    X(414, "Request-URI Too Long") \
+    X(415, "Unsupported Media Type") \
+    X(416, "Requested Range Not Satisfiable") \
+    X(417, "Expectation Failed") \
+    X(418, "I'm a teapot") \
+    X(422, "Unprocessable Entity") \
+    X(423, "Locked") \
+    X(424, "Failed Dependency") \
+    X(425, "Unordered Collection") \
+    X(426, "Upgrade Required") \
+    X(428, "Precondition Required") \
+    X(429, "Too Many Requests") \
+    X(431, "Request Header Fields Too Large") \
+    X(444, "No Response") \
+    X(449, "Retry With") \
+    X(499, "Client Closed Request") \
+    \
+    /* 5xx Internal Server Error */ \
+    X(500, "Internal Server Error") \
+    X(501, "Not Implemented") \
+    X(502, "Bad Gateway") \
+    X(503, "Service Unavailable") \
+    X(504, "Gateway Timeout") \
+    X(505, "HTTP Version Not Supported") \
+    X(506, "Variant Also Negotiates") \
+    X(507, "Insufficient Storage") \
+    X(508, "Loop Detected") \
+    X(509, "Bandwidth Limit Exceeded") \
+    X(510, "Not Extended")
 
-std::map<HttpResponseStatus, QByteArray> phrases {
-    // 1xx Informational
-    {HttpResponseStatus::CONTINUE, "Continue"},
-    {HttpResponseStatus::SWITCHING_PROTOCOLS, "Switching Protocols"},
-    {HttpResponseStatus::PROCESSING, "Processing"},
-    {HttpResponseStatus::CHECKPOINT, "Checkpoint"},
+#define TUFAO_STATUS_LINE(version, code, phrase) \
+    "HTTP/" version " " #code " " phrase "\r\n"
 
-    // 2xx Successful
-    {HttpResponseStatus::OK, "OK"},
-    {HttpResponseStatus::CREATED, "Created"},
-    {HttpResponseStatus::ACCEPTED, "Accepted"},
-    {HttpResponseStatus::NON_AUTHORITATIVE_INFORMATION,
-                "Non-Authoritative Information"},
-    {HttpResponseStatus::NO_CONTENT, "No Content"},
-    {HttpResponseStatus::RESET_CONTENT, "Reset Content"},
-    {HttpResponseStatus::PARTIAL_CONTENT, "Partial Content"},
-    {HttpResponseStatus::MULTI_STATUS, "Multi-Status"},
-    {HttpResponseStatus::ALREADY_REPORTED, "Already Reported"},
-    {HttpResponseStatus::IM_USED, "IM Used"},
+namespace Tufao {
 
-    // 3xx Redirection
-    {HttpResponseStatus::MULTIPLE_CHOICES, "Multiple Choices"},
-    {HttpResponseStatus::MOVED_PERMANENTLY, "Moved Permanently"},
-    {HttpResponseStatus::FOUND, "Found"},
-    {HttpResponseStatus::SEE_OTHER, "See Other"},
-    {HttpResponseStatus::NOT_MODIFIED, "Not Modified"},
-    {HttpResponseStatus::USE_PROXY, "Use Proxy"},
-    {HttpResponseStatus::SWITCH_PROXY, "Switch Proxy"},
-    {HttpResponseStatus::TEMPORARY_REDIRECT, "Temporary Redirect"},
-    {HttpResponseStatus::RESUME_INCOMPLETE, "Resume Incomplete"},
+QByteArray reasonPhrase(HttpResponseStatus statusCode)
+{
+    switch (int(statusCode)) {
+#define TUFAO_X(code, phrase) \
+    case code: \
+        return QByteArrayLiteral(phrase);
 
-    // 4xx Client Error
-    {HttpResponseStatus::BAD_REQUEST, "Bad Request"},
-    {HttpResponseStatus::UNAUTHORIZED, "Unauthorized"},
-    {HttpResponseStatus::PAYMENT_REQUIRED, "Payment Required"},
-    {HttpResponseStatus::FORBIDDEN, "Forbidden"},
-    {HttpResponseStatus::NOT_FOUND, "Not Found"},
-    {HttpResponseStatus::METHOD_NOT_ALLOWED, "Method Not Allowed"},
-    {HttpResponseStatus::NOT_ACCEPTABLE, "Not Acceptable"},
-    {HttpResponseStatus::PROXY_AUTHENTICATION_REQUIRED,
-                "Proxy Authentication Required"},
-    {HttpResponseStatus::REQUEST_TIMEOUT, "Request Timeout"},
-    {HttpResponseStatus::CONFLICT, "Conflict"},
-    {HttpResponseStatus::GONE, "Gone"},
-    {HttpResponseStatus::LENGTH_REQUIRED, "Length Required"},
-    {HttpResponseStatus::PRECONDITION_FAILED, "Precondition Failed"},
-    {HttpResponseStatus::REQUEST_ENTITY_TOO_LARGE, "Request Entity Too Large"},
-    {HttpResponseStatus::REQUEST_URI_TOO_LONG, "Request-URI Too Long"},
-    {HttpResponseStatus::UNSUPPORTED_MEDIA_TYPE, "Unsupported Media Type"},
-    {HttpResponseStatus::REQUESTED_RANGE_NOT_SATISFIABLE,
-                "Requested Range Not Satisfiable"},
-    {HttpResponseStatus::EXPECTATION_FAILED, "Expectation Failed"},
-    {HttpResponseStatus::I_AM_A_TEAPOT, "I'm a teapot"},
-    {HttpResponseStatus::UNPROCESSABLE_ENTITY, "Unprocessable Entity"},
-    {HttpResponseStatus::LOCKED, "Locked"},
-    {HttpResponseStatus::FAILED_DEPENDENCY, "Failed Dependency"},
-    {HttpResponseStatus::UNORDERED_COLLECTION, "Unordered Collection"},
-    {HttpResponseStatus::UPGRADE_REQUIRED, "Upgrade Required"},
-    {HttpResponseStatus::PRECONDITION_REQUIRED, "Precondition Required"},
-    {HttpResponseStatus::TOO_MANY_REQUESTS, "Too Many Requests"},
-    {HttpResponseStatus::REQUEST_HEADER_FIELDS_TOO_LARGE,
-                "Request Header Fields Too Large"},
-    {HttpResponseStatus::NO_RESPONSE, "No Response"},
-    {HttpResponseStatus::RETRY_WITH, "Retry With"},
-    {HttpResponseStatus::CLIENT_CLOSED_REQUEST, "Client Closed Request"},
+    TUFAO_STATUS_CODES(TUFAO_X)
 
-    // 5xx Internal Server Error
-    {HttpResponseStatus::INTERNAL_SERVER_ERROR, "Internal Server Error"},
-    {HttpResponseStatus::NOT_IMPLEMENTED, "Not Implemented"},
-    {HttpResponseStatus::BAD_GATEWAY, "Bad Gateway"},
-    {HttpResponseStatus::SERVICE_UNAVAILABLE, "Service Unavailable"},
-    {HttpResponseStatus::GATEWAY_TIMEOUT, "Gateway Timeout"},
-    {HttpResponseStatus::HTTP_VERSION_NOT_SUPPORTED,
-                "HTTP Version Not Supported"},
-    {HttpResponseStatus::VARIANT_ALSO_NEGOTIATES, "Variant Also Negotiates"},
-    {HttpResponseStatus::INSUFFICIENT_STORAGE, "Insufficient Storage"},
-    {HttpResponseStatus::LOOP_DETECTED, "Loop Detected"},
-    {HttpResponseStatus::BANDWIDTH_LIMIT_EXCEEDED, "Bandwidth Limit Exceeded"},
-    {HttpResponseStatus::NOT_EXTENDED, "Not Extended"}
-};
+#undef TUFAO_X
+    default:
+        return QByteArray();
+    }
+}
 
-QByteArray reasonPhrase(HttpResponseStatus statusCode)
+StatusLine statusLine(HttpResponseStatus statusCode,
+                      HttpServerResponse::Options options)
 {
-    return phrases[statusCode];
+    bool http10 = options.testFlag(HttpServerResponse::HTTP_1_0);
+
+    switch (int(statusCode)) {
+#define TUFAO_X(code, phrase) \
+    case code: \
+        if (http10) { \
+            static const char line[] = TUFAO_STATUS_LINE("1.0", code, phrase); \
+            return StatusLine{line, int(sizeof(line)) - 1}; \
+        } else { \
+            static const char line[] = TUFAO_STATUS_LINE("1.1", code, phrase); \
+            return StatusLine{line, int(sizeof(line)) - 1}; \
+        }
+
+    TUFAO_STATUS_CODES(TUFAO_X)
+
+#undef TUFAO_X
+    default:
+        return StatusLine{0, 0};
+    }
 }
 
 } // namespace Tufao
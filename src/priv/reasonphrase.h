@@ -23,8 +23,24 @@
 
 namespace Tufao {
 
+/*
+  A complete, ready-to-send status line (CRLF included) with static storage.
+ */
+struct StatusLine
+{
+    const char *data;
+    int size;
+};
+
 QByteArray reasonPhrase(HttpResponseStatus statusCode);
 
+/*
+  Returns the status line for \p statusCode in the HTTP version set in
+  \p options or a StatusLine with size 0 if \p statusCode is unknown.
+ */
+StatusLine statusLine(HttpResponseStatus statusCode,
+                      HttpServerResponse::Options options);
+
 } // namespace Tufao
 
 #endif // TUFAO_PRIV_REASONPHRASE_H
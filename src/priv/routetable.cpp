@@ -0,0 +1,76 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "routetable.h"
+#include "../routeparameters.h"
+
+#include <algorithm>
+
+namespace Tufao {
+
+void RouteTable::clear()
+{
+    tree.clear();
+    fallbacks.clear();
+}
+
+void RouteTable::insert(const QRegularExpression &pattern, int index)
+{
+    if (!tree.insert(pattern, index))
+        fallbacks.push_back(Fallback{index, pattern});
+}
+
+void RouteTable::match(const QString &path, Matches &matches) const
+{
+    const int begin = matches.size();
+    tree.match(path, matches);
+
+    if (fallbacks.isEmpty())
+        return;
+
+    for (const auto &fallback: fallbacks) {
+        QRegularExpressionMatch regexMatch{fallback.pattern.match(path)};
+
+        if (!regexMatch.hasMatch())
+            continue;
+
+        RouteTree::Match match{fallback.index, {}};
+        for (int i = 1;i <= regexMatch.lastCapturedIndex();++i) {
+            match.captures.append({regexMatch.capturedStart(i),
+                                   regexMatch.capturedLength(i)});
+        }
+        matches.push_back(match);
+    }
+
+    std::sort(matches.begin() + begin, matches.end(),
+              [](const RouteTree::Match &a, const RouteTree::Match &b) {
+                  return a.index < b.index;
+              });
+}
+
+void appendRouteParameters(RouteParameters &parameters, const QString &path,
+                           const RouteTree::Captures &captures,
+                           const QStringList &names)
+{
+    for (int i = 0;i != captures.size();++i) {
+        parameters.append(path, captures[i].begin, captures[i].size,
+                          names.value(i + 1));
+    }
+}
+
+} // namespace Tufao
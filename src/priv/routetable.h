@@ -0,0 +1,70 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_ROUTETABLE_H
+#define TUFAO_PRIV_ROUTETABLE_H
+
+#include "routetree.h"
+
+#include <QtCore/QStringList>
+
+namespace Tufao {
+
+class RouteParameters;
+
+/*
+  The routes of a router. The patterns accepted by RouteTree are matched by the
+  tree and the remaining ones by their regular expressions.
+ */
+class RouteTable
+{
+public:
+    typedef QVector<RouteTree::Match> Matches;
+
+    void clear();
+
+    void insert(const QRegularExpression &pattern, int index);
+
+    /*
+      Appends the routes matching path to matches, ordered by index, just like
+      RouteTree::match does.
+     */
+    void match(const QString &path, Matches &matches) const;
+
+private:
+    struct Fallback
+    {
+        int index;
+        QRegularExpression pattern;
+    };
+
+    RouteTree tree;
+    QVector<Fallback> fallbacks;
+};
+
+/*
+  Appends captures, made in path, to parameters. names is the value of
+  QRegularExpression::namedCaptureGroups for the matched pattern.
+ */
+void appendRouteParameters(RouteParameters &parameters, const QString &path,
+                           const RouteTree::Captures &captures,
+                           const QStringList &names);
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_ROUTETABLE_H
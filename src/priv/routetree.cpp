@@ -0,0 +1,397 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "routetree.h"
+
+#include <algorithm>
+
+namespace Tufao {
+
+static inline bool isWordCharacter(QChar c)
+{
+    ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z')
+        || (u >= '0' && u <= '9') || u == '_';
+}
+
+static inline bool isDigit(QChar c)
+{
+    return c.unicode() >= '0' && c.unicode() <= '9';
+}
+
+// Characters that have a special meaning outside of a character class
+static inline bool isMetaCharacter(QChar c)
+{
+    switch (c.unicode()) {
+    case '\\': case '^': case '$': case '.': case '|': case '?': case '*':
+    case '+': case '(': case ')': case '[': case ']': case '{': case '}':
+        return true;
+    default:
+        return false;
+    }
+}
+
+RouteTree::RouteTree() :
+    nodes(1)
+{
+}
+
+void RouteTree::clear()
+{
+    nodes.clear();
+    nodes.resize(1);
+}
+
+bool RouteTree::insert(const QRegularExpression &pattern, int index)
+{
+    if (!pattern.isValid()
+        || pattern.patternOptions() != QRegularExpression::NoPatternOption) {
+        return false;
+    }
+
+    QVector<Token> tokens;
+    bool anchored;
+    if (!compile(pattern.pattern(), tokens, anchored))
+        return false;
+
+    int node = 0;
+    for (const Token &token: tokens) {
+        switch (token.kind) {
+        case LITERAL:
+            node = insertLiteral(node, token.literal);
+            break;
+        case SEGMENT:
+        case WORD:
+        case DIGITS:
+            node = insertParameter(node, token.kind);
+            break;
+        case TAIL:
+        case OPTIONAL_TAIL:
+        {
+            // compile() only accepts tails at the end of the pattern
+            TailRoute tail;
+            tail.kind = token.kind;
+            tail.anchored = anchored;
+            tail.index = index;
+            nodes[node].tails.push_back(tail);
+            return true;
+        }
+        }
+    }
+
+    if (anchored)
+        nodes[node].exact.push_back(index);
+    else
+        nodes[node].prefix.push_back(index);
+
+    return true;
+}
+
+void RouteTree::match(const QString &path, QVector<Match> &matches) const
+{
+    const int begin = matches.size();
+    Captures captures;
+    match(0, path, 0, captures, matches);
+
+    std::sort(matches.begin() + begin, matches.end(),
+              [](const Match &a, const Match &b) {
+                  return a.index < b.index;
+              });
+}
+
+bool RouteTree::compile(const QString &pattern, QVector<Token> &tokens,
+                        bool &anchored)
+{
+    anchored = false;
+
+    // The empty regex matches everything
+    if (pattern.isEmpty())
+        return true;
+
+    if (pattern[0] != '^')
+        return false;
+
+    const int size = pattern.size();
+    QString literal;
+
+    for (int i = 1;i != size;) {
+        const QChar c = pattern[i];
+
+        if (c == '\\') {
+            // Escaped punctuation is literal, the rest (\d, \w, \b, ...) isn't
+            if (i + 1 == size || pattern[i + 1].unicode() > 127
+                || isWordCharacter(pattern[i + 1])) {
+                return false;
+            }
+
+            literal.append(pattern[i + 1]);
+            i += 2;
+        } else if (c == '$') {
+            if (i + 1 != size)
+                return false;
+
+            anchored = true;
+            ++i;
+        } else if (c == '(') {
+            int j = i + 1;
+
+            // Named groups
+            bool named = false;
+            if (pattern.midRef(j).startsWith(QLatin1String("?P<"))) {
+                j += 3;
+                named = true;
+            } else if (pattern.midRef(j).startsWith(QLatin1String("?<"))) {
+                j += 2;
+                named = true;
+            }
+
+            if (named) {
+                int nameBegin = j;
+                while (j != size && isWordCharacter(pattern[j]))
+                    ++j;
+
+                if (j == nameBegin || j == size || pattern[j] != '>')
+                    return false;
+
+                ++j;
+            }
+
+            int end = pattern.indexOf(QLatin1Char(')'), j);
+            if (end == -1)
+                return false;
+
+            const QStringRef body = pattern.midRef(j, end - j);
+            Token token;
+
+            if (body == QLatin1String("[^/]+")) {
+                token.kind = SEGMENT;
+            } else if (body == QLatin1String("\\w+")) {
+                token.kind = WORD;
+            } else if (body == QLatin1String("\\d+")
+                       || body == QLatin1String("[0-9]+")) {
+                token.kind = DIGITS;
+            } else if (body == QLatin1String(".+")) {
+                token.kind = TAIL;
+            } else if (body == QLatin1String(".*")) {
+                token.kind = OPTIONAL_TAIL;
+            } else {
+                return false;
+            }
+
+            i = end + 1;
+            const QStringRef next = pattern.midRef(i);
+
+            if (token.kind == TAIL || token.kind == OPTIONAL_TAIL) {
+                // Only at the end
+                if (!next.isEmpty() && next != QLatin1String("$"))
+                    return false;
+            } else {
+                // Segment captures must be followed by a slash or the end, so
+                // they can't backtrack
+                if (next != QLatin1String("$") && !next.startsWith('/')
+                    && !next.startsWith(QLatin1String("\\/"))) {
+                    return false;
+                }
+            }
+
+            if (!literal.isEmpty()) {
+                Token text;
+                text.kind = LITERAL;
+                text.literal = literal;
+                tokens.push_back(text);
+                literal.clear();
+            }
+
+            tokens.push_back(token);
+        } else if (isMetaCharacter(c)) {
+            return false;
+        } else {
+            literal.append(c);
+            ++i;
+        }
+    }
+
+    if (!literal.isEmpty()) {
+        Token text;
+        text.kind = LITERAL;
+        text.literal = literal;
+        tokens.push_back(text);
+    }
+
+    return true;
+}
+
+int RouteTree::insertLiteral(int node, QString label)
+{
+    while (!label.isEmpty()) {
+        int i = 0;
+        const int edgesSize = nodes[node].edges.size();
+        while (i != edgesSize && nodes[node].edges[i].label[0] != label[0])
+            ++i;
+
+        if (i == edgesSize) {
+            Edge edge;
+            edge.label = label;
+            edge.child = nodes.size();
+            nodes[node].edges.push_back(edge);
+            nodes.push_back(Node());
+            return edge.child;
+        }
+
+        const QString &edgeLabel = nodes[node].edges[i].label;
+        const int maxCommon = qMin(edgeLabel.size(), label.size());
+        int common = 1;
+        while (common != maxCommon && edgeLabel[common] == label[common])
+            ++common;
+
+        if (common != edgeLabel.size()) {
+            // Split the edge
+            Edge lower;
+            lower.label = edgeLabel.mid(common);
+            lower.child = nodes[node].edges[i].child;
+
+            const int middle = nodes.size();
+            nodes.push_back(Node());
+            nodes[middle].edges.push_back(lower);
+
+            Edge &upper = nodes[node].edges[i];
+            upper.label.truncate(common);
+            upper.child = middle;
+        }
+
+        node = nodes[node].edges[i].child;
+        label.remove(0, common);
+    }
+
+    return node;
+}
+
+int RouteTree::insertParameter(int node, Kind kind)
+{
+    for (const ParameterEdge &edge: nodes[node].parameters) {
+        if (edge.kind == kind)
+            return edge.child;
+    }
+
+    ParameterEdge edge;
+    edge.kind = kind;
+    edge.child = nodes.size();
+    nodes[node].parameters.push_back(edge);
+    nodes.push_back(Node());
+    return edge.child;
+}
+
+void RouteTree::match(int nodeIndex, const QString &path, int position,
+                      Captures &captures, QVector<Match> &matches) const
+{
+    const Node &node = nodes[nodeIndex];
+    const int size = path.size();
+
+    for (int index: node.prefix) {
+        Match match;
+        match.index = index;
+        match.captures = captures;
+        matches.push_back(match);
+    }
+
+    // Like in PCRE, '$' also matches before a final newline
+    const bool atEnd = position == size
+        || (position + 1 == size && path[position] == '\n');
+
+    if (atEnd) {
+        for (int index: node.exact) {
+            Match match;
+            match.index = index;
+            match.captures = captures;
+            matches.push_back(match);
+        }
+    }
+
+    if (!node.tails.isEmpty()) {
+        // '.' doesn't match newlines
+        int newline = path.indexOf(QLatin1Char('\n'), position);
+        if (newline == -1)
+            newline = size;
+
+        for (const TailRoute &tail: node.tails) {
+            if (tail.anchored && newline != size && newline + 1 != size)
+                continue;
+
+            Capture capture;
+            capture.begin = position;
+            capture.size = newline - position;
+
+            if (tail.kind == TAIL && !capture.size)
+                continue;
+
+            Match match;
+            match.index = tail.index;
+            match.captures = captures;
+            match.captures.append(capture);
+            matches.push_back(match);
+        }
+    }
+
+    if (position == size)
+        return;
+
+    for (const Edge &edge: node.edges) {
+        if (edge.label[0] != path[position])
+            continue;
+
+        if (path.midRef(position, edge.label.size()) == edge.label) {
+            match(edge.child, path, position + edge.label.size(), captures,
+                  matches);
+        }
+
+        // The labels of the edges start with different characters
+        break;
+    }
+
+    for (const ParameterEdge &edge: node.parameters) {
+        int end = position;
+        switch (edge.kind) {
+        case SEGMENT:
+            while (end != size && path[end] != '/')
+                ++end;
+            break;
+        case WORD:
+            while (end != size && isWordCharacter(path[end]))
+                ++end;
+            break;
+        case DIGITS:
+            while (end != size && isDigit(path[end]))
+                ++end;
+            break;
+        default:
+            break;
+        }
+
+        if (end == position)
+            continue;
+
+        Capture capture;
+        capture.begin = position;
+        capture.size = end - position;
+        captures.append(capture);
+        match(edge.child, path, end, captures, matches);
+        captures.removeLast();
+    }
+}
+
+} // namespace Tufao
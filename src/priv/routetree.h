@@ -0,0 +1,143 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_ROUTETREE_H
+#define TUFAO_PRIV_ROUTETREE_H
+
+#include <QtCore/QRegularExpression>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QVector>
+
+namespace Tufao {
+
+/*
+  A radix tree that matches url paths against the regular expressions used by
+  the routers without running them.
+
+  Only the simple patterns that are common in routes are compiled into the
+  tree: a '^' anchor followed by literal text and capture groups that span
+  whole path segments ("([^/]+)", "(\w+)", "(\d+)" and "([0-9]+)", optionally
+  named) or the rest of the path ("(.*)" and "(.+)"), optionally ending with a
+  '$' anchor. A pattern without the final anchor matches any path starting
+  with the compiled part, just like the regex would. The empty pattern matches
+  every path.
+
+  The tree gives exactly the same results as QRegularExpression::match for the
+  patterns it accepts. The other patterns are refused by insert() and must be
+  matched using the regex.
+
+  The cost of a lookup depends on the length of the path, not on the number of
+  routes.
+ */
+class Q_DECL_EXPORT RouteTree
+{
+public:
+    struct Capture
+    {
+        int begin;
+        int size;
+    };
+
+    typedef QVarLengthArray<Capture, 4> Captures;
+
+    struct Match
+    {
+        int index;
+        Captures captures;
+    };
+
+    RouteTree();
+
+    void clear();
+
+    /*
+      Adds the route for the mapping at index. Returns false if pattern can't
+      be represented in the tree.
+     */
+    bool insert(const QRegularExpression &pattern, int index);
+
+    /*
+      Appends the routes matching path to matches, ordered by index. Each route
+      matches at most once.
+     */
+    void match(const QString &path, QVector<Match> &matches) const;
+
+private:
+    enum Kind
+    {
+        LITERAL,
+        // Segment captures
+        SEGMENT,
+        WORD,
+        DIGITS,
+        // Captures of the rest of the path
+        TAIL,
+        OPTIONAL_TAIL
+    };
+
+    struct Token
+    {
+        Kind kind;
+        QString literal;
+    };
+
+    struct Edge
+    {
+        QString label;
+        int child;
+    };
+
+    struct ParameterEdge
+    {
+        Kind kind;
+        int child;
+    };
+
+    struct TailRoute
+    {
+        Kind kind;
+        bool anchored;
+        int index;
+    };
+
+    struct Node
+    {
+        QVector<Edge> edges;
+        QVector<ParameterEdge> parameters;
+        QVector<TailRoute> tails;
+
+        // Routes ending here with and without the '$' anchor
+        QVector<int> exact;
+        QVector<int> prefix;
+    };
+
+    static bool compile(const QString &pattern, QVector<Token> &tokens,
+                        bool &anchored);
+
+    int insertLiteral(int node, QString label);
+    int insertParameter(int node, Kind kind);
+
+    void match(int node, const QString &path, int position,
+               Captures &captures, QVector<Match> &matches) const;
+
+    QVector<Node> nodes;
+};
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_ROUTETREE_H
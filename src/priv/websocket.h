@@ -21,10 +21,14 @@
 
 #include <boost/http/reader/response.hpp>
 #include "../websocket.h"
+#include "websocketframe.h"
+#include "permessagedeflate.h"
 
 #include <QtNetwork/QAbstractSocket>
 #include <QtCore/QtEndian>
 
+#include <cstring>
+
 #if defined(NO_ERROR) && defined(_WIN32)
 # define TUFAO_WINERROR_WORKAROUND
 # undef NO_ERROR
@@ -109,6 +113,9 @@ struct WebSocketClientNode
     QByteArray expectedWebSocketAccept;
 };
 
+// Frames up to this size are built on the stack and written at once
+static const int SMALL_FRAME_SIZE = 256;
+
 struct WebSocket::Priv
 {
     union Frame
@@ -135,6 +142,11 @@ struct WebSocket::Priv
             return bytes[0] & 0x40;
         }
 
+        void setRsv1()
+        {
+            bytes[0] |= 0x40;
+        }
+
         bool rsv2() const
         {
             return bytes[0] & 0x20;
@@ -194,41 +206,47 @@ struct WebSocket::Priv
 
         void writePayload(QAbstractSocket *socket, bool isClientNode, const QByteArray &data)
         {
-            int size = data.size();
-
-            if (size < 126)
-                setPayloadLength(size);
-            else if (size <= 65535)
-                setPayloadLength(126);
-            else
-                setPayloadLength(127);
-
-            socket->write(bytes, 2);
-
-            if (size >= 126 && size <= 65535) {
-                uchar chunk[2];
-                qToBigEndian(quint16(size), chunk);
-                socket->write(reinterpret_cast<char*>(chunk), sizeof(chunk));
-            } else if (size > 65535) {
-                uchar chunk[8];
-                qToBigEndian(quint64(size), chunk);
-                socket->write(reinterpret_cast<char*>(chunk), sizeof(chunk));
-            }
+            const int size = data.size();
+
+            union
+            {
+                quint32 key;
+                quint8 pieces[4];
+            } mask;
 
-            if (isClientNode) {
-                union
-                {
-                    quint32 key;
-                    uchar pieces[4];
-                } mask;
+            if (isClientNode)
                 mask.key = qrand();
-                socket->write(reinterpret_cast<char*>(mask.pieces), 4);
 
-                for (int i = 0;i != size;++i) {
-                    uchar byte = mask.pieces[i % 4] ^ data[i];
-                    socket->write(reinterpret_cast<char*>(&byte), 1);
+            char header[MAX_FRAME_HEADER_SIZE];
+            const int headerSize
+                = encodeFrameHeader(header, quint8(bytes[0]), size,
+                                    isClientNode ? mask.pieces : NULL);
+
+            if (headerSize + size <= SMALL_FRAME_SIZE) {
+                char frame[SMALL_FRAME_SIZE];
+                std::memcpy(frame, header, headerSize);
+                std::memcpy(frame + headerSize, data.constData(), size);
+
+                if (isClientNode) {
+                    quint8 index = 0;
+                    maskPayload(frame + headerSize, size, mask.pieces, index);
                 }
+
+                socket->write(frame, headerSize + size);
+            } else if (isClientNode) {
+                QByteArray frame;
+                frame.reserve(headerSize + size);
+                frame.append(header, headerSize);
+                frame.append(data);
+
+                quint8 index = 0;
+                maskPayload(frame.data() + headerSize, size, mask.pieces,
+                            index);
+                socket->write(frame);
             } else {
+                // QAbstractSocket copies both into its write buffer, so the
+                // payload isn't copied again to be prepended with the header
+                socket->write(header, headerSize);
                 socket->write(data);
             }
         }
@@ -284,6 +302,7 @@ struct WebSocket::Priv
         messageType(WebSocketMessageType::BINARY_MESSAGE),
         lastError(WebSocketError::NO_ERROR),
         state(CLOSED),
+        bufferOffset(0),
         parsingState(PARSING_FRAME),
         clientNode(NULL)
     {}
@@ -297,8 +316,23 @@ struct WebSocket::Priv
     WebSocketMessageType messageType;
     WebSocketError lastError;
 
+    // Returns the received bytes not parsed yet
+    const char *unparsedData() const
+    {
+        return buffer.constData() + bufferOffset;
+    }
+
+    int unparsedSize() const
+    {
+        return buffer.size() - bufferOffset;
+    }
+
     QAbstractSocket *socket;
+
+    // Bytes before bufferOffset were already parsed. They are only discarded
+    // when new data arrives, so parsing a field doesn't move the buffer.
     QByteArray buffer;
+    int bufferOffset;
 
     State state;
     bool isClientNode;
@@ -318,6 +352,8 @@ struct WebSocket::Priv
     // Used in fragmented messages
     quint8 fragmentOpcode;
     QByteArray fragment;
+
+    PerMessageDeflate deflate;
 };
 
 inline bool hasValueCaseInsensitively(const QList<QByteArray> &values,
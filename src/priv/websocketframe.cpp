@@ -0,0 +1,96 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "websocketframe.h"
+
+#include <QtCore/QtEndian>
+
+#include <cstring>
+
+namespace Tufao {
+
+int encodeFrameHeader(char *header, quint8 firstByte, quint64 payloadSize,
+                      const quint8 *mask)
+{
+    uchar *out = reinterpret_cast<uchar*>(header);
+    int size = 2;
+
+    out[0] = firstByte;
+    out[1] = mask ? 0x80 : 0;
+
+    if (payloadSize < 126) {
+        out[1] |= quint8(payloadSize);
+    } else if (payloadSize <= 65535) {
+        out[1] |= 126;
+        qToBigEndian(quint16(payloadSize), out + size);
+        size += 2;
+    } else {
+        out[1] |= 127;
+        qToBigEndian(payloadSize, out + size);
+        size += 8;
+    }
+
+    if (mask) {
+        std::memcpy(out + size, mask, 4);
+        size += 4;
+    }
+
+    return size;
+}
+
+QByteArray encodeFrame(quint8 firstByte, const QByteArray &payload)
+{
+    char header[MAX_FRAME_HEADER_SIZE];
+    const int headerSize = encodeFrameHeader(header, firstByte, payload.size(),
+                                             NULL);
+
+    QByteArray frame;
+    frame.reserve(headerSize + payload.size());
+    frame.append(header, headerSize);
+    frame.append(payload);
+    return frame;
+}
+
+void maskPayload(char *data, qint64 size, const quint8 key[4], quint8 &index)
+{
+    index %= 4;
+
+    // The key rotated to the current phase and repeated to fill a word. A
+    // word has a multiple of 4 bytes, so the phase is the same after each word.
+    quint8 bytes[8];
+    for (int i = 0;i != 8;++i)
+        bytes[i] = key[(index + i) % 4];
+
+    quint64 mask;
+    std::memcpy(&mask, bytes, sizeof(mask));
+
+    qint64 i = 0;
+    for (;i + 8 <= size;i += 8) {
+        quint64 word;
+        std::memcpy(&word, data + i, sizeof(word));
+        word ^= mask;
+        std::memcpy(data + i, &word, sizeof(word));
+    }
+
+    for (int j = 0;i != size;++i, ++j)
+        data[i] ^= bytes[j];
+
+    index = quint8((index + size) % 4);
+}
+
+} // namespace Tufao
@@ -0,0 +1,60 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_WEBSOCKETFRAME_H
+#define TUFAO_PRIV_WEBSOCKETFRAME_H
+
+#include <QtCore/QByteArray>
+
+namespace Tufao {
+
+// 2 bytes, 8 bytes of extended payload length and 4 bytes of masking key
+static const int MAX_FRAME_HEADER_SIZE = 14;
+
+/*
+  Serializes the header of a frame to header, which must have room for
+  MAX_FRAME_HEADER_SIZE bytes, and returns its size.
+
+  firstByte holds the FIN, RSV and opcode bits. The payload length is encoded
+  in the shortest form. If mask isn't null, the MASK bit is set and the 4 bytes
+  of mask are appended.
+ */
+Q_DECL_EXPORT int encodeFrameHeader(char *header, quint8 firstByte,
+                                    quint64 payloadSize, const quint8 *mask);
+
+/*
+  Returns a complete unmasked frame (the kind sent by server nodes) carrying
+  payload. Broadcasts write the same frame to many connections.
+ */
+Q_DECL_EXPORT QByteArray encodeFrame(quint8 firstByte,
+                                     const QByteArray &payload);
+
+/*
+  XORs the size bytes at data with the masking key, in place.
+
+  index is the position in key used for the first byte. It's updated, so a
+  payload split across several calls is unmasked with the right key bytes.
+
+  The payload is processed 8 bytes at a time.
+ */
+Q_DECL_EXPORT void maskPayload(char *data, qint64 size, const quint8 key[4],
+                               quint8 &index);
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_WEBSOCKETFRAME_H
@@ -0,0 +1,102 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_PRIV_WEBSOCKETGROUP_H
+#define TUFAO_PRIV_WEBSOCKETGROUP_H
+
+#include "../websocketgroup.h"
+#include "../websocket.h"
+
+#include <functional>
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+
+class QThread;
+
+namespace Tufao {
+
+/*
+  A WebSocketGroupWorker runs jobs in the thread it lives in. It's used to
+  write to the members of a WebSocketGroup that live in other threads.
+ */
+class WebSocketGroupWorker : public QObject
+{
+    Q_OBJECT
+public:
+    // Thread-safe
+    void post(std::function<void()> job);
+
+private slots:
+    void run();
+
+private:
+    QMutex mutex;
+    QVector<std::function<void()>> jobs;
+};
+
+struct WebSocketGroup::Priv
+{
+    struct Member
+    {
+        // The key is only compared, as the member may be already destroyed
+        QObject *key;
+        QPointer<WebSocket> websocket;
+    };
+
+    typedef QVector<Member> Members;
+
+    // The members living in the same thread
+    struct Shard
+    {
+        Members members;
+        // Null until a broadcast is made from another thread
+        WebSocketGroupWorker *worker = nullptr;
+    };
+
+    struct Location
+    {
+        QThread *thread;
+        int index;
+    };
+
+    bool remove(QObject *key);
+
+    void broadcast(quint8 opcode, const QByteArray &payload);
+
+    /*
+      Writes the message to the open members. It runs in the thread where the
+      members live. members is a copy, so the group can change while the
+      message is delivered.
+     */
+    static void deliver(Members members, quint8 opcode,
+                        const QByteArray &payload, const QByteArray &frame,
+                        qint64 maxPendingBytes);
+
+    static const qint64 DEFAULT_MAX_PENDING_BYTES = 1024 * 1024;
+
+    QHash<QThread*, Shard> shards;
+    QHash<QObject*, Location> locations;
+    qint64 maxPendingBytes = DEFAULT_MAX_PENDING_BYTES;
+};
+
+} // namespace Tufao
+
+#endif // TUFAO_PRIV_WEBSOCKETGROUP_H
@@ -0,0 +1,215 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_ROUTEPARAMETERS_H
+#define TUFAO_ROUTEPARAMETERS_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVarLengthArray>
+
+#include "tufao_global.h"
+
+namespace Tufao {
+
+/*!
+  This class stores the texts captured by the routers from the url's path
+  component.
+
+  The captures are stored as positions in the path, so filling this object
+  doesn't copy any text and, for up to 4 captures, doesn't allocate memory. The
+  texts are accessed as QStringRef objects pointing into the path. The captures
+  made by nested routers are appended, in the order they were made.
+
+  \include route_parameters.cpp
+
+  \note
+  The references returned by this class are invalidated when the parameters
+  are changed.
+
+  \par
+  \note
+  All member functions of this class are inlined and should add the minimum (if
+  any) of overhead.
+
+  \sa
+  HttpServerRequest::routeParameters
+
+  \since
+  1.5
+  */
+class TUFAO_EXPORT RouteParameters
+{
+public:
+    /*!
+      Returns the number of captures.
+     */
+    int size() const;
+
+    /*!
+      Returns true if there are no captures.
+     */
+    bool isEmpty() const;
+
+    /*!
+      Returns the text captured at \p index.
+
+      A null QStringRef is returned for groups that didn't participate in the
+      match.
+     */
+    QStringRef at(int index) const;
+
+    /*!
+      Same as at().
+     */
+    QStringRef operator [](int index) const;
+
+    /*!
+      Returns the name of the capture at \p index or a null string if the
+      capture group is unnamed.
+     */
+    QString name(int index) const;
+
+    /*!
+      Returns the index of the last capture named \p name or -1 if there is no
+      such capture. The last capture is used so the captures of nested routers
+      take precedence.
+     */
+    int indexOf(const QString &name) const;
+
+    /*!
+      Returns the text of the last capture named \p name or a null QStringRef
+      if there is no such capture.
+     */
+    QStringRef value(const QString &name) const;
+
+    /*!
+      Returns a copy of the captured texts.
+     */
+    QStringList toStringList() const;
+
+    /*!
+      Appends a capture of \p size characters starting at \p position in \p
+      path. A negative \p position represents a group that didn't participate
+      in the match.
+
+      \note
+      \p path is implicitly shared, not copied.
+     */
+    void append(const QString &path, int position, int size,
+                const QString &name = QString());
+
+    /*!
+      Removes the captures after the first \p size ones.
+     */
+    void truncate(int size);
+
+    /*!
+      Removes all captures.
+     */
+    void clear();
+
+private:
+    struct Parameter
+    {
+        QString path;
+        QString name;
+        int position;
+        int size;
+    };
+
+    QVarLengthArray<Parameter, 4> parameters;
+};
+
+inline int RouteParameters::size() const
+{
+    return parameters.size();
+}
+
+inline bool RouteParameters::isEmpty() const
+{
+    return parameters.isEmpty();
+}
+
+inline QStringRef RouteParameters::at(int index) const
+{
+    const Parameter &parameter = parameters[index];
+
+    if (parameter.position < 0)
+        return QStringRef();
+
+    return QStringRef(&parameter.path, parameter.position, parameter.size);
+}
+
+inline QStringRef RouteParameters::operator [](int index) const
+{
+    return at(index);
+}
+
+inline QString RouteParameters::name(int index) const
+{
+    return parameters[index].name;
+}
+
+inline int RouteParameters::indexOf(const QString &name) const
+{
+    for (int i = parameters.size() - 1;i >= 0;--i) {
+        if (parameters[i].name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+inline QStringRef RouteParameters::value(const QString &name) const
+{
+    int i = indexOf(name);
+    return i == -1 ? QStringRef() : at(i);
+}
+
+inline QStringList RouteParameters::toStringList() const
+{
+    QStringList list;
+    list.reserve(parameters.size());
+
+    for (int i = 0;i != parameters.size();++i)
+        list.push_back(at(i).toString());
+
+    return list;
+}
+
+inline void RouteParameters::append(const QString &path, int position,
+                                    int size, const QString &name)
+{
+    parameters.append(Parameter{path, name, position, size});
+}
+
+inline void RouteParameters::truncate(int size)
+{
+    if (size < parameters.size())
+        parameters.resize(size);
+}
+
+inline void RouteParameters::clear()
+{
+    parameters.clear();
+}
+
+} // namespace Tufao
+
+#endif // TUFAO_ROUTEPARAMETERS_H
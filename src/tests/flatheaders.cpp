@@ -0,0 +1,113 @@
+#include "flatheaders.h"
+#include <QtTest/QTest>
+#include "../flatheaders.h"
+
+#include <cstring>
+
+using namespace Tufao;
+
+void FlatHeadersTest::lookup()
+{
+    FlatHeaders headers;
+    QVERIFY(headers.isEmpty());
+
+    headers.insert("Host", "example.com");
+    headers.insert("Content-Length", "42");
+
+    QCOMPARE(headers.size(), 2);
+    QVERIFY(headers.contains("host"));
+    QVERIFY(headers.contains("CONTENT-LENGTH"));
+    QVERIFY(!headers.contains("Connection"));
+    QCOMPARE(headers.value("hOsT"), QByteArray{"example.com"});
+    QCOMPARE(headers.value("Connection", "close"), QByteArray{"close"});
+    QCOMPARE(FlatHeaders::hash("Content-Length", 14),
+             FlatHeaders::hash("content-length", 14));
+
+    headers.replace("content-length", "7");
+    QCOMPARE(headers.size(), 2);
+    QCOMPARE(headers.value("Content-Length"), QByteArray{"7"});
+
+    headers.replace("Connection", "close");
+    QCOMPARE(headers.size(), 3);
+    QVERIFY(headers.begin()[2].name == IByteArray{"Connection"});
+
+    headers.clear();
+    QVERIFY(headers.isEmpty());
+}
+
+void FlatHeadersTest::multipleValues()
+{
+    FlatHeaders headers;
+    headers.insert("Set-Cookie", "a=1");
+    headers.insert("Vary", "Accept-Encoding");
+    headers.insert("set-cookie", "b=2");
+
+    QCOMPARE(headers.count("Set-Cookie"), 2);
+    QCOMPARE(headers.value("Set-Cookie"), QByteArray{"b=2"});
+    QCOMPARE(headers.values("Set-Cookie"),
+             (QList<QByteArray>{"b=2", "a=1"}));
+
+    // Same order as Tufao::Headers
+    Headers hash;
+    hash.insert("Set-Cookie", "a=1");
+    hash.insert("set-cookie", "b=2");
+    QCOMPARE(headers.values("Set-Cookie"), hash.values("Set-Cookie"));
+}
+
+void FlatHeadersTest::remove()
+{
+    FlatHeaders headers;
+    for (int i = 0;i != 20;++i) {
+        headers.insert(i % 2 ? "X-Odd" : "X-Even",
+                       QByteArray::number(i));
+    }
+    QCOMPARE(headers.size(), 20);
+
+    QCOMPARE(headers.remove("x-odd"), 10);
+    QCOMPARE(headers.remove("X-Missing"), 0);
+    QCOMPARE(headers.size(), 10);
+    QVERIFY(!headers.contains("X-Odd"));
+
+    int i = 0;
+    for (const auto &entry: headers) {
+        QVERIFY(entry.name == IByteArray{"X-Even"});
+        QCOMPARE(entry.value, QByteArray::number(i));
+        i += 2;
+    }
+}
+
+void FlatHeadersTest::conversion()
+{
+    Headers original;
+    original.insert("Host", "example.com");
+    original.insert("Accept", "text/html");
+    original.insert("Accept", "application/json");
+
+    FlatHeaders headers{original};
+    QCOMPARE(headers.size(), 3);
+    QCOMPARE(headers.values("accept"), original.values("accept"));
+
+    const Headers converted{headers.toHeaders()};
+    QCOMPARE(converted.size(), original.size());
+    QCOMPARE(converted.values("Accept"), original.values("Accept"));
+    QCOMPARE(converted.value("Host"), original.value("Host"));
+}
+
+void FlatHeadersTest::intern()
+{
+    const IByteArray host1{FlatHeaders::intern("Host", 4)};
+    const IByteArray host2{FlatHeaders::intern(QByteArray{"Host"})};
+    QVERIFY(host1 == IByteArray{"Host"});
+    QVERIFY(host1.constData() == host2.constData());
+
+    // The bytes are kept as received
+    const IByteArray lowercase{FlatHeaders::intern("host", 4)};
+    QCOMPARE(lowercase.size(), 4);
+    QVERIFY(std::memcmp(lowercase.constData(), "host", 4) == 0);
+    QVERIFY(lowercase.constData() != host1.constData());
+
+    const QByteArray custom{"X-Custom"};
+    QVERIFY(FlatHeaders::intern(custom).constData() == custom.constData());
+}
+
+QTEST_APPLESS_MAIN(FlatHeadersTest)
@@ -0,0 +1,12 @@
+#include <QtCore/QObject>
+
+class FlatHeadersTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void lookup();
+    void multipleValues();
+    void remove();
+    void conversion();
+    void intern();
+};
@@ -0,0 +1,118 @@
+#include "httpdate.h"
+#include <QtTest/QTest>
+#include "../priv/httpdate.h"
+#include "../priv/rfc1123.h"
+#include "../priv/rfc1036.h"
+#include "../priv/asctime.h"
+
+using namespace Tufao;
+
+void HttpDateTest::parse_data()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<qint64>("timestamp");
+
+    QTest::newRow("RFC 1123")
+        << QByteArray{"Sun, 06 Nov 1994 08:49:37 GMT"} << qint64{784111777};
+    QTest::newRow("RFC 850")
+        << QByteArray{"Sunday, 06-Nov-94 08:49:37 GMT"} << qint64{784111777};
+    QTest::newRow("asctime")
+        << QByteArray{"Sun Nov  6 08:49:37 1994"} << qint64{784111777};
+    QTest::newRow("asctime with two digit day")
+        << QByteArray{"Wed Nov 16 08:49:37 1994"} << qint64{784975777};
+    QTest::newRow("UNIX epoch")
+        << QByteArray{"Thu, 01 Jan 1970 00:00:00 GMT"} << qint64{0};
+    QTest::newRow("Before the UNIX epoch")
+        << QByteArray{"Tue, 01 Dec 1903 00:00:00 GMT"}
+        << qint64{-2085523200};
+    QTest::newRow("Leap day")
+        << QByteArray{"Tue, 29 Feb 2000 23:59:59 GMT"} << qint64{951868799};
+}
+
+void HttpDateTest::parse()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(qint64, timestamp);
+
+    qint64 result = -1;
+    QVERIFY(parseHttpDate(value, result));
+    QCOMPARE(result, timestamp);
+}
+
+void HttpDateTest::invalid_data()
+{
+    QTest::addColumn<QByteArray>("value");
+
+    QTest::newRow("empty") << QByteArray{};
+    QTest::newRow("garbage") << QByteArray{"garbage"};
+    QTest::newRow("truncated") << QByteArray{"Sun, 06 Nov 1994 08:49"};
+    QTest::newRow("trailing data")
+        << QByteArray{"Sun, 06 Nov 1994 08:49:37 GMT "};
+    QTest::newRow("lowercase month")
+        << QByteArray{"Sun, 06 nov 1994 08:49:37 GMT"};
+    QTest::newRow("unknown month")
+        << QByteArray{"Sun, 06 Foo 1994 08:49:37 GMT"};
+    QTest::newRow("no leap day")
+        << QByteArray{"Thu, 29 Feb 1900 00:00:00 GMT"};
+    QTest::newRow("invalid hour")
+        << QByteArray{"Sun, 06 Nov 1994 24:49:37 GMT"};
+    QTest::newRow("missing zone")
+        << QByteArray{"Sunday, 06-Nov-94 08:49:37"};
+    QTest::newRow("asctime without year")
+        << QByteArray{"Sun Nov  6 08:49:37"};
+}
+
+void HttpDateTest::invalid()
+{
+    QFETCH(QByteArray, value);
+
+    qint64 result = 42;
+    QVERIFY(!parseHttpDate(value, result));
+    QCOMPARE(result, qint64{42});
+}
+
+void HttpDateTest::benchmark_data()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<bool>("regex");
+
+    QTest::newRow("RFC 1123, single-pass")
+        << QByteArray{"Sun, 06 Nov 1994 08:49:37 GMT"} << false;
+    QTest::newRow("RFC 1123, QRegularExpression")
+        << QByteArray{"Sun, 06 Nov 1994 08:49:37 GMT"} << true;
+    QTest::newRow("RFC 850, single-pass")
+        << QByteArray{"Sunday, 06-Nov-94 08:49:37 GMT"} << false;
+    QTest::newRow("RFC 850, QRegularExpression")
+        << QByteArray{"Sunday, 06-Nov-94 08:49:37 GMT"} << true;
+    QTest::newRow("asctime, single-pass")
+        << QByteArray{"Sun Nov  6 08:49:37 1994"} << false;
+    QTest::newRow("asctime, QRegularExpression")
+        << QByteArray{"Sun Nov  6 08:49:37 1994"} << true;
+}
+
+void HttpDateTest::benchmark()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(bool, regex);
+
+    // The QRegularExpression path mirrors what Headers::toDateTime used to do
+    if (regex) {
+        QBENCHMARK {
+            Rfc1123 rfc1123(value);
+            if (!rfc1123) {
+                Rfc1036 rfc1036(value);
+                if (!rfc1036) {
+                    Asctime asctime(value);
+                    QVERIFY(static_cast<bool>(asctime));
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            qint64 timestamp;
+            QVERIFY(parseHttpDate(value, timestamp));
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(HttpDateTest)
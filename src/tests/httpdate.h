@@ -0,0 +1,13 @@
+#include <QtCore/QObject>
+
+class HttpDateTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void parse_data();
+    void parse();
+    void invalid_data();
+    void invalid();
+    void benchmark_data();
+    void benchmark();
+};
@@ -1,9 +1,50 @@
 #include "httpfileserver.h"
+#include "loopback.h"
 #include <QtTest/QTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QDir>
+#include <QtCore/QMap>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTemporaryFile>
 #include "../httpfileserver.h"
+#include "../priv/httpfilecache.h"
 
 using namespace Tufao;
 
+// Serves fileName to a GET request with the given extra headers
+static QByteArray serve(const QString &fileName, const QByteArray &headers)
+{
+    LoopbackRequest loopback;
+    if (!loopback.send("GET / HTTP/1.1\r\n"
+                       "Host: localhost\r\n"
+                       + headers + "\r\n")) {
+        return QByteArray();
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    HttpServerResponse response{buffer, loopback.request->responseOptions()};
+    HttpFileServer::serveFile(fileName, *loopback.request, response);
+    return buffer.data();
+}
+
+static QByteArray headerValue(const QByteArray &message,
+                              const QByteArray &name)
+{
+    const QByteArray key("\r\n" + name + ": ");
+    int i = message.indexOf(key);
+    if (i == -1)
+        return QByteArray();
+
+    i += key.size();
+    return message.mid(i, message.indexOf("\r\n", i) - i);
+}
+
+static QByteArray body(const QByteArray &message)
+{
+    return message.mid(message.indexOf("\r\n\r\n") + 4);
+}
+
 void HttpFileServerTest::properties_data()
 {
     QTest::addColumn<QString>("dir");
@@ -25,4 +66,370 @@ void HttpFileServerTest::properties()
     QCOMPARE(fileserver.dir(), QString(""));
 }
 
-QTEST_APPLESS_MAIN(HttpFileServerTest)
+void HttpFileServerTest::serveFileBody()
+{
+    QByteArray contents;
+    for (int i = 0;i != 1000;++i)
+        contents += QByteArray::number(i) + '\n';
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    file.close();
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1
+            | HttpServerResponse::KEEP_ALIVE};
+
+    QVERIFY(HttpFileServer::serveFile(file.fileName(), response,
+                                      HttpResponseStatus::NOT_FOUND));
+
+    QVERIFY(buffer.data().startsWith("HTTP/1.1 404 Not Found\r\n"));
+    QVERIFY(buffer.data().contains("\r\nContent-Length: "
+                                   + QByteArray::number(contents.size())
+                                   + "\r\n"));
+    QVERIFY(!buffer.data().contains("Transfer-Encoding"));
+    QVERIFY(buffer.data().endsWith("\r\n\r\n" + contents));
+}
+
+void HttpFileServerTest::streamWindow()
+{
+    QCOMPARE(HttpFileServer::streamWindow(), qint64(0));
+
+    HttpFileServer::setStreamWindow(65536);
+    QCOMPARE(HttpFileServer::streamWindow(), qint64(65536));
+
+    HttpFileServer::setStreamWindow(-1);
+    QCOMPARE(HttpFileServer::streamWindow(), qint64(65536));
+
+    HttpFileServer::setStreamWindow(0);
+    QCOMPARE(HttpFileServer::streamWindow(), qint64(0));
+}
+
+void HttpFileServerTest::streaming()
+{
+    QByteArray contents(300000, Qt::Uninitialized);
+    for (int i = 0;i != contents.size();++i)
+        contents[i] = char(i % 251);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    file.close();
+
+    LoopbackRequest loopback;
+    QVERIFY(loopback.send("GET / HTTP/1.1\r\n"
+                          "Host: localhost\r\n"
+                          "\r\n"));
+
+    // The file is many times bigger than the window and than a single read
+    const qint64 bufferSize = HttpFileServer::bufferSize();
+    HttpFileServer::setBufferSize(1000);
+    HttpFileServer::setBufferSize(0);
+    QCOMPARE(HttpFileServer::bufferSize(), qint64(1000));
+    HttpFileServer::setStreamWindow(4096);
+
+    HttpServerResponse response{loopback.request->socket(),
+            loopback.request->responseOptions()};
+    HttpFileServer::serveFile(file.fileName(), *loopback.request, response);
+    HttpFileServer::setStreamWindow(0);
+
+    QByteArray message;
+    QSignalSpy readyRead(&loopback.client, SIGNAL(readyRead()));
+    int end = -1;
+    while (end == -1 || message.size() < end + contents.size()) {
+        if (!loopback.client.bytesAvailable())
+            QVERIFY(readyRead.wait());
+
+        message += loopback.client.readAll();
+        if (end == -1 && message.contains("\r\n\r\n"))
+            end = message.indexOf("\r\n\r\n") + 4;
+    }
+
+    QVERIFY(message.startsWith("HTTP/1.1 200 OK\r\n"));
+    QCOMPARE(headerValue(message, "Content-Length"),
+             QByteArray::number(contents.size()));
+    QCOMPARE(body(message), contents);
+
+    // Nothing is sent after the end of the response
+    QTest::qWait(100);
+    QCOMPARE(loopback.client.bytesAvailable(), qint64(0));
+
+    HttpFileServer::setBufferSize(bufferSize);
+}
+
+void HttpFileServerTest::cache()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write("first"), qint64(5));
+    QVERIFY(file.flush());
+
+    HttpFileCache cache;
+    HttpFileCache::Entry entry;
+
+    // Disabled by default
+    QVERIFY(!cache.get(QFileInfo(file.fileName()), entry));
+
+    cache.setMaxSize(1024);
+    QVERIFY(cache.get(QFileInfo(file.fileName()), entry));
+    QCOMPARE(entry.contents, QByteArray("first"));
+    QCOMPARE(entry.size, qint64(5));
+    QVERIFY(entry.etag.startsWith('"') && entry.etag.endsWith('"'));
+
+    // A change in the size invalidates the entry
+    QCOMPARE(file.write(" and second"), qint64(11));
+    QVERIFY(file.flush());
+    QVERIFY(cache.get(QFileInfo(file.fileName()), entry));
+    QCOMPARE(entry.contents, QByteArray("first and second"));
+
+    // Files larger than the limit aren't cached
+    cache.setMaxFileSize(4);
+    QVERIFY(!cache.get(QFileInfo(file.fileName()), entry));
+}
+
+void HttpFileServerTest::conditionals()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write("0123456789"), qint64(10));
+    QVERIFY(file.flush());
+
+    const QByteArray ok("HTTP/1.1 200 OK\r\n");
+    const QByteArray notModified("HTTP/1.1 304 Not Modified\r\n");
+    const QByteArray preconditionFailed("HTTP/1.1 412 Precondition Failed\r\n");
+    const QByteArray partialContent("HTTP/1.1 206 Partial Content\r\n");
+
+    QByteArray response(serve(file.fileName(), ""));
+    QVERIFY(response.startsWith(ok));
+    const QByteArray etag(headerValue(response, "ETag"));
+    const QByteArray lastModified(headerValue(response, "Last-Modified"));
+    QVERIFY(etag.startsWith('"') && etag.endsWith('"'));
+    QVERIFY(lastModified.size());
+
+    // If-None-Match uses the weak comparison and returns early
+    response = serve(file.fileName(), "If-None-Match: " + etag + "\r\n");
+    QVERIFY(response.startsWith(notModified));
+    QCOMPARE(headerValue(response, "ETag"), etag);
+    QVERIFY(response.endsWith("\r\n\r\n"));
+    QVERIFY(!response.contains("0123456789"));
+
+    response = serve(file.fileName(), "If-None-Match: \"a\", W/" + etag
+                     + "\r\n");
+    QVERIFY(response.startsWith(notModified));
+
+    response = serve(file.fileName(), "If-None-Match: *\r\n");
+    QVERIFY(response.startsWith(notModified));
+
+    response = serve(file.fileName(), "If-None-Match: \"a\"\r\n");
+    QVERIFY(response.startsWith(ok));
+    QCOMPARE(body(response), QByteArray("0123456789"));
+
+    // If-None-Match takes precedence over If-Modified-Since
+    response = serve(file.fileName(),
+                     "If-None-Match: \"a\"\r\n"
+                     "If-Modified-Since: " + lastModified + "\r\n");
+    QVERIFY(response.startsWith(ok));
+
+    response = serve(file.fileName(),
+                     "If-Modified-Since: " + lastModified + "\r\n");
+    QVERIFY(response.startsWith(notModified));
+
+    // If-Match uses the strong comparison
+    response = serve(file.fileName(), "If-Match: \"a\"\r\n");
+    QVERIFY(response.startsWith(preconditionFailed));
+    QVERIFY(response.endsWith("\r\n\r\n"));
+
+    response = serve(file.fileName(), "If-Match: W/" + etag + "\r\n");
+    QVERIFY(response.startsWith(preconditionFailed));
+
+    response = serve(file.fileName(), "If-Match: \"a\", " + etag + "\r\n");
+    QVERIFY(response.startsWith(ok));
+
+    response = serve(file.fileName(), "If-Match: *\r\n");
+    QVERIFY(response.startsWith(ok));
+
+    // If-Range accepts a strong entity-tag or the exact modification date
+    response = serve(file.fileName(),
+                     "Range: bytes=2-5\r\n"
+                     "If-Range: " + etag + "\r\n");
+    QVERIFY(response.startsWith(partialContent));
+    QCOMPARE(body(response), QByteArray("2345"));
+
+    response = serve(file.fileName(),
+                     "Range: bytes=2-5\r\n"
+                     "If-Range: W/" + etag + "\r\n");
+    QVERIFY(response.startsWith(ok));
+    QCOMPARE(body(response), QByteArray("0123456789"));
+
+    response = serve(file.fileName(),
+                     "Range: bytes=2-5\r\n"
+                     "If-Range: \"a\"\r\n");
+    QVERIFY(response.startsWith(ok));
+
+    response = serve(file.fileName(),
+                     "Range: bytes=2-5\r\n"
+                     "If-Range: " + lastModified + "\r\n");
+    QVERIFY(response.startsWith(partialContent));
+    QCOMPARE(body(response), QByteArray("2345"));
+
+    response = serve(file.fileName(),
+                     "Range: bytes=2-5\r\n"
+                     "If-Range: Sun, 06 Nov 1994 08:49:37 GMT\r\n");
+    QVERIFY(response.startsWith(ok));
+    QCOMPARE(body(response), QByteArray("0123456789"));
+}
+
+void HttpFileServerTest::byteranges()
+{
+    const QByteArray contents("0123456789abcdefghijklmnopqrstuvwxyz"
+                              "ABCDEFGHIJKLMNOPQRSTUVWXYZ@#");
+    QCOMPARE(contents.size(), 64);
+
+    QTemporaryFile file(QDir::tempPath() + "/XXXXXX.txt");
+    QVERIFY(file.open());
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    QVERIFY(file.flush());
+
+    const QByteArray partialContent("HTTP/1.1 206 Partial Content\r\n");
+    const QByteArray multipart("multipart/byteranges; boundary=");
+
+    {
+        // Overlapping and unsorted ranges are coalesced in two parts
+        QByteArray response(serve(file.fileName(),
+                                  "Range: bytes=10-13,0-5,3-8\r\n"));
+        QVERIFY(response.startsWith(partialContent));
+
+        const QByteArray contentType(headerValue(response, "Content-Type"));
+        QVERIFY(contentType.startsWith(multipart));
+        const QByteArray boundary(contentType.mid(multipart.size()));
+        QVERIFY(boundary.size());
+
+        const QByteArray expected("--" + boundary + "\r\n"
+                                  "Content-Type: text/plain\r\n"
+                                  "Content-Range: bytes 0-8/64\r\n"
+                                  "\r\n"
+                                  "012345678"
+                                  "\r\n--" + boundary + "\r\n"
+                                  "Content-Type: text/plain\r\n"
+                                  "Content-Range: bytes 10-13/64\r\n"
+                                  "\r\n"
+                                  "abcd"
+                                  "\r\n--" + boundary + "--\r\n");
+        QCOMPARE(body(response), expected);
+        QCOMPARE(headerValue(response, "Content-Length"),
+                 QByteArray::number(expected.size()));
+    }
+    {
+        // Adjacent ranges are merged in a single part
+        QByteArray response(serve(file.fileName(),
+                                  "Range: bytes=4-7,0-3\r\n"));
+        QVERIFY(response.startsWith(partialContent));
+        QCOMPARE(headerValue(response, "Content-Range"),
+                 QByteArray("bytes 0-7/64"));
+        QCOMPARE(headerValue(response, "Content-Length"), QByteArray("8"));
+        QCOMPARE(body(response), contents.left(8));
+    }
+    {
+        // Up to MAX_RANGES ranges are served as multipart
+        QByteArray ranges("Range: bytes=0-0");
+        for (int i = 1;i != 16;++i)
+            ranges += ',' + QByteArray::number(i * 2) + '-'
+                + QByteArray::number(i * 2);
+
+        QByteArray response(serve(file.fileName(), ranges + "\r\n"));
+        QVERIFY(response.startsWith(partialContent));
+        QVERIFY(headerValue(response, "Content-Type").startsWith(multipart));
+        QCOMPARE(body(response).count("Content-Range: "), 16);
+        QCOMPARE(headerValue(response, "Content-Length"),
+                 QByteArray::number(body(response).size()));
+
+        // Too many ranges get the entire entity
+        ranges += ",40-40";
+        response = serve(file.fileName(), ranges + "\r\n");
+        QVERIFY(response.startsWith("HTTP/1.1 200 OK\r\n"));
+        QCOMPARE(headerValue(response, "Content-Length"), QByteArray("64"));
+        QCOMPARE(body(response), contents);
+    }
+}
+
+void HttpFileServerTest::precompressed_data()
+{
+    QTest::addColumn<QByteArray>("acceptEncoding");
+    QTest::addColumn<QByteArray>("coding");
+
+    QTest::newRow("no Accept-Encoding") << QByteArray() << QByteArray();
+    QTest::newRow("gzip") << QByteArray("gzip") << QByteArray("gzip");
+    QTest::newRow("x-gzip") << QByteArray("x-gzip") << QByteArray("gzip");
+    QTest::newRow("ties prefer br")
+        << QByteArray("gzip, deflate, br") << QByteArray("br");
+    QTest::newRow("higher q-value wins")
+        << QByteArray("gzip;q=0.9, br;q=0.5") << QByteArray("gzip");
+    QTest::newRow("refused coding")
+        << QByteArray("br;q=0, gzip;q=0.2") << QByteArray("gzip");
+    QTest::newRow("no sibling for zstd") << QByteArray("zstd") << QByteArray();
+    QTest::newRow("identity preferred")
+        << QByteArray("gzip;q=0.1, identity;q=1") << QByteArray();
+    QTest::newRow("identity as good as the coding")
+        << QByteArray("br;q=0.5, identity;q=0.5") << QByteArray();
+    QTest::newRow("coding preferred over identity")
+        << QByteArray("br, identity;q=0.5") << QByteArray("br");
+    QTest::newRow("wildcard doesn't favour identity")
+        << QByteArray("br, *") << QByteArray("br");
+}
+
+void HttpFileServerTest::precompressed()
+{
+    QFETCH(QByteArray, acceptEncoding);
+    QFETCH(QByteArray, coding);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // The contents differ in size, so the files have different ETags
+    QMap<QByteArray, QByteArray> contents;
+    contents[QByteArray()] = "The original contents of the file\n";
+    contents["gzip"] = "gzip contents";
+    contents["br"] = "br";
+
+    const QString fileName(dir.path() + "/file.txt");
+    const QMap<QByteArray, QString> suffixes{{QByteArray(), QString()},
+                                             {"gzip", ".gz"}, {"br", ".br"}};
+    for (auto i = suffixes.begin();i != suffixes.end();++i) {
+        QFile file(fileName + *i);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(contents[i.key()]),
+                 qint64(contents[i.key()].size()));
+    }
+
+    const QByteArray headers(acceptEncoding.isNull() ? QByteArray()
+                             : "Accept-Encoding: " + acceptEncoding + "\r\n");
+
+    HttpFileServer::setServePrecompressed(true);
+    const QByteArray message = serve(fileName, headers);
+    const QByteArray identity = serve(fileName, QByteArray());
+    HttpFileServer::setServePrecompressed(false);
+
+    QVERIFY(message.startsWith("HTTP/1.1 200 OK\r\n"));
+    QCOMPARE(body(message), contents[coding]);
+    QCOMPARE(headerValue(message, "Content-Encoding"), coding);
+    QCOMPARE(headerValue(message, "Vary"), QByteArray("Accept-Encoding"));
+
+    // The type is the one of the original file
+    QCOMPARE(headerValue(message, "Content-Type"), QByteArray("text/plain"));
+
+    // The ETag belongs to the chosen file, so it validates only requests
+    // that would choose the same file
+    const QByteArray etag(headerValue(message, "ETag"));
+    QVERIFY(!etag.isEmpty());
+    QCOMPARE(etag == headerValue(identity, "ETag"), coding.isEmpty());
+
+    HttpFileServer::setServePrecompressed(true);
+    const QByteArray revalidated = serve(fileName, headers
+                                         + "If-None-Match: " + etag + "\r\n");
+    HttpFileServer::setServePrecompressed(false);
+    QVERIFY(revalidated.startsWith("HTTP/1.1 304 Not Modified\r\n"));
+}
+
+QTEST_GUILESS_MAIN(HttpFileServerTest)
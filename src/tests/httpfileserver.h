@@ -6,4 +6,12 @@ class HttpFileServerTest: public QObject
 private slots:
     void properties_data();
     void properties();
+    void serveFileBody();
+    void streamWindow();
+    void streaming();
+    void cache();
+    void conditionals();
+    void byteranges();
+    void precompressed_data();
+    void precompressed();
 };
@@ -0,0 +1,67 @@
+#include "httpserver.h"
+#include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtCore/QUrl>
+#include <QtNetwork/QTcpSocket>
+#include "../httpserver.h"
+#include "../httpserverrequest.h"
+#include "../httpserverresponse.h"
+
+using namespace Tufao;
+
+void HttpServerTest::workerThreads()
+{
+    QMutex mutex;
+    QSet<QThread*> factoryThreads;
+    QSet<QThread*> handlerThreads;
+
+    HttpServer server;
+    server.setWorkerThreads(2, [&]() -> HttpServer::Handler {
+        {
+            QMutexLocker locker(&mutex);
+            factoryThreads.insert(QThread::currentThread());
+        }
+
+        return [&](HttpServerRequest &request,
+                   HttpServerResponse &response) -> bool {
+            {
+                QMutexLocker locker(&mutex);
+                handlerThreads.insert(QThread::currentThread());
+            }
+
+            response.writeHead(HttpResponseStatus::OK);
+            response.end(request.url().path().toUtf8());
+            return true;
+        };
+    });
+    QCOMPARE(server.workerThreads(), 2);
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    for (int i = 0;i != 4;++i) {
+        QByteArray path = '/' + QByteArray::number(i);
+
+        QTcpSocket socket;
+        QSignalSpy disconnected(&socket, SIGNAL(disconnected()));
+        socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        socket.write("GET " + path + " HTTP/1.0\r\n\r\n");
+
+        // Spins the main event loop, where connections are accepted
+        QVERIFY(disconnected.wait());
+
+        QByteArray response = socket.readAll();
+        QVERIFY(response.startsWith("HTTP/1.0 200 OK\r\n"));
+        QVERIFY(response.endsWith("\r\n\r\n" + path));
+    }
+
+    QMutexLocker locker(&mutex);
+
+    // Connections are handed off round-robin to both workers
+    QCOMPARE(handlerThreads.size(), 2);
+    QCOMPARE(factoryThreads, handlerThreads);
+    QVERIFY(!handlerThreads.contains(QThread::currentThread()));
+}
+
+QTEST_GUILESS_MAIN(HttpServerTest)
@@ -0,0 +1,8 @@
+#include <QtCore/QObject>
+
+class HttpServerTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void workerThreads();
+};
@@ -0,0 +1,133 @@
+#include "httpserverrequest.h"
+#include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include "../httpserverrequest.h"
+#include "../flatheaders.h"
+
+using namespace Tufao;
+
+void HttpServerRequestTest::bodyWatermarks()
+{
+    QTcpServer listener;
+    QVERIFY(listener.listen(QHostAddress::LocalHost));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, listener.serverPort());
+    QVERIFY(listener.waitForNewConnection(5000));
+    QTcpSocket *socket = listener.nextPendingConnection();
+    QVERIFY(client.waitForConnected());
+
+    HttpServerRequest request(*socket);
+    request.setBodyWatermarks(8, 4);
+    QCOMPARE(request.bodyHighWatermark(), qint64(8));
+    QCOMPARE(request.bodyLowWatermark(), qint64(4));
+
+    QSignalSpy data(&request, SIGNAL(data()));
+    QSignalSpy end(&request, SIGNAL(end()));
+
+    QByteArray expected{"0123456789abcdefghijklmnopqrstuv"};
+    client.write("POST / HTTP/1.1\r\n"
+                 "Host: localhost\r\n"
+                 "Content-Length: 32\r\n"
+                 "\r\n" + expected);
+    QVERIFY(client.waitForBytesWritten());
+
+    // The body isn't consumed, so the reading stops at the high watermark
+    QTRY_VERIFY(data.count() > 0);
+    QTest::qWait(100);
+    int chunks = data.count();
+    QCOMPARE(end.count(), 0);
+
+    // Above the low watermark, the reading remains paused
+    QByteArray body = request.readBody(1);
+    QCOMPARE(body, QByteArray("0"));
+    QTest::qWait(100);
+    QCOMPARE(data.count(), chunks);
+    QCOMPARE(end.count(), 0);
+
+    // Draining the buffered body resumes the reading
+    connect(&request, &HttpServerRequest::data, [&]() {
+        body += request.readBody();
+    });
+    body += request.readBody();
+
+    QTRY_COMPARE(end.count(), 1);
+    QVERIFY(data.count() > chunks);
+    body += request.readBody();
+    QCOMPARE(body, expected);
+}
+
+void HttpServerRequestTest::maxBodySize()
+{
+    QTcpServer listener;
+    QVERIFY(listener.listen(QHostAddress::LocalHost));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, listener.serverPort());
+    QVERIFY(listener.waitForNewConnection(5000));
+    QTcpSocket *socket = listener.nextPendingConnection();
+    QVERIFY(client.waitForConnected());
+
+    HttpServerRequest request(*socket);
+    request.setMaxBodySize(4);
+    QCOMPARE(request.maxBodySize(), qint64(4));
+
+    QSignalSpy ready(&request, SIGNAL(ready()));
+    QSignalSpy disconnected(&client, SIGNAL(disconnected()));
+
+    client.write("POST / HTTP/1.1\r\n"
+                 "Host: localhost\r\n"
+                 "Content-Length: 10\r\n"
+                 "\r\n"
+                 "0123456789");
+
+    // The announced length is above the limit, so the body isn't read
+    QVERIFY(disconnected.wait());
+    QVERIFY(client.readAll()
+            .startsWith("HTTP/1.1 413 Request Entity Too Large\r\n"));
+    QCOMPARE(ready.count(), 0);
+}
+
+void HttpServerRequestTest::headers()
+{
+    QTcpServer listener;
+    QVERIFY(listener.listen(QHostAddress::LocalHost));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, listener.serverPort());
+    QVERIFY(listener.waitForNewConnection(5000));
+    QTcpSocket *socket = listener.nextPendingConnection();
+    QVERIFY(client.waitForConnected());
+
+    HttpServerRequest request(*socket);
+    QSignalSpy ready(&request, SIGNAL(ready()));
+
+    client.write("GET / HTTP/1.1\r\n"
+                 "Host: localhost\r\n"
+                 "Accept: text/html\r\n"
+                 "X-Custom: a\r\n"
+                 "x-custom: b\r\n"
+                 "\r\n");
+    QVERIFY(ready.wait());
+
+    // The parsed headers are stored in the flat container
+    const FlatHeaders &flat = request.flatHeaders();
+    QCOMPARE(flat.size(), 4);
+    QCOMPARE(flat.value("host"), QByteArray("localhost"));
+    QCOMPARE(flat.value("Accept"), QByteArray("text/html"));
+    QCOMPARE(flat.count("X-Custom"), 2);
+
+    // The Headers object is built on demand with the same contents
+    Headers &headers = request.headers();
+    QCOMPARE(headers, flat.toHeaders());
+    QCOMPARE(headers.value("Host"), QByteArray("localhost"));
+    QCOMPARE(headers.values("x-custom").size(), 2);
+
+    // Changes made through headers() are kept between calls
+    headers.replace("Accept", "text/plain");
+    QCOMPARE(request.headers().value("Accept"), QByteArray("text/plain"));
+}
+
+QTEST_GUILESS_MAIN(HttpServerRequestTest)
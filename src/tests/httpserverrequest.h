@@ -0,0 +1,10 @@
+#include <QtCore/QObject>
+
+class HttpServerRequestTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void bodyWatermarks();
+    void maxBodySize();
+    void headers();
+};
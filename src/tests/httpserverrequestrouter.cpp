@@ -1,10 +1,45 @@
 #include "httpserverrequestrouter.h"
+#include "loopback.h"
 #include <QtTest/QTest>
+#include <QtCore/QBuffer>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QVariant>
+#include <QtCore/QVector>
 #include "../httpserverrequestrouter.h"
 
 using namespace Tufao;
 
+// A handler that records its id in calls
+static HttpServerRequestRouter::Handler record(QVector<int> &calls, int id,
+                                               bool accept = false)
+{
+    return [&calls, id, accept](HttpServerRequest&,
+                                HttpServerResponse&) -> bool {
+        calls.push_back(id);
+        return accept;
+    };
+}
+
+// Routes a request and returns the ids of the handlers called, in order
+static QVector<int> route(HttpServerRequestRouter &router, QVector<int> &calls,
+                          const QByteArray &method, const QByteArray &path)
+{
+    LoopbackRequest loopback;
+    if (!loopback.send(method + ' ' + path + " HTTP/1.1\r\n"
+                       "Host: localhost\r\n"
+                       "\r\n")) {
+        return QVector<int>{-1};
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    HttpServerResponse response{buffer, loopback.request->responseOptions()};
+
+    calls.clear();
+    router.handleRequest(*loopback.request, response);
+    return calls;
+}
+
 struct Helper
 {
     Helper(bool &b): b(b) {}
@@ -55,4 +90,114 @@ void HttpServerRequestRouterTest::mappings()
             }), 1);
 }
 
-QTEST_APPLESS_MAIN(HttpServerRequestRouterTest)
+void HttpServerRequestRouterTest::cacheSize()
+{
+    HttpServerRequestRouter httpServerRequestRouter;
+    QCOMPARE(httpServerRequestRouter.cacheSize(), 1024);
+
+    httpServerRequestRouter.setCacheSize(16);
+    QCOMPARE(httpServerRequestRouter.cacheSize(), 16);
+
+    httpServerRequestRouter.setCacheSize(0);
+    QCOMPARE(httpServerRequestRouter.cacheSize(), 0);
+}
+
+void HttpServerRequestRouterTest::methods()
+{
+    QVector<int> calls;
+
+    HttpServerRequestRouter router{
+        {QRegularExpression{"^/a$"}, "POST", record(calls, 0)},
+        {QRegularExpression{"^/a$"}, record(calls, 1)},
+        {QRegularExpression{"^/a$"}, "GET", record(calls, 2)},
+        {QRegularExpression{"^/"}, record(calls, 3)},
+        {QRegularExpression{"^/b$"}, "GET", record(calls, 4)}
+    };
+
+    // Method-specific and any-method handlers are tried in mapping order
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{1, 2, 3}));
+    QCOMPARE(route(router, calls, "POST", "/a"), (QVector<int>{0, 1, 3}));
+    QCOMPARE(route(router, calls, "GET", "/b"), (QVector<int>{3, 4}));
+
+    // Methods without specific handlers only see the any-method ones
+    QCOMPARE(route(router, calls, "PUT", "/a"), (QVector<int>{1, 3}));
+    QCOMPARE(route(router, calls, "PUT", "/b"), (QVector<int>{3}));
+
+    // The search stops at the first handler that accepts the request
+    router.map({QRegularExpression{"^/c$"}, "GET", record(calls, 5, true)});
+    router.map({QRegularExpression{"^/c$"}, record(calls, 6, true)});
+    QCOMPARE(route(router, calls, "GET", "/c"), (QVector<int>{3, 5}));
+    QCOMPARE(route(router, calls, "POST", "/c"), (QVector<int>{3, 6}));
+}
+
+void HttpServerRequestRouterTest::cacheInvalidation()
+{
+    QVector<int> calls;
+
+    HttpServerRequestRouter router;
+    router.map({QRegularExpression{"^/a$"}, record(calls, 0)});
+
+    // The second lookup is answered by the cache
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{0}));
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{0}));
+
+    router.map({QRegularExpression{"^/a$"}, "GET", record(calls, 1)});
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{0, 1}));
+    QCOMPARE(route(router, calls, "POST", "/a"), (QVector<int>{0}));
+
+    router.unmap(0);
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{1}));
+    QCOMPARE(route(router, calls, "POST", "/a"), QVector<int>{});
+
+    router.map({
+        {QRegularExpression{"^/"}, record(calls, 2)},
+        {QRegularExpression{"^/a$"}, "POST", record(calls, 3)}
+    });
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{1, 2}));
+    QCOMPARE(route(router, calls, "POST", "/a"), (QVector<int>{2, 3}));
+
+    router.clear();
+    QCOMPARE(route(router, calls, "GET", "/a"), QVector<int>{});
+    QCOMPARE(route(router, calls, "POST", "/a"), QVector<int>{});
+
+    // Without the cache, the results are the same
+    router.setCacheSize(0);
+    router.map({QRegularExpression{"^/a$"}, record(calls, 4)});
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{4}));
+    QCOMPARE(route(router, calls, "GET", "/a"), (QVector<int>{4}));
+}
+
+void HttpServerRequestRouterTest::customData()
+{
+    QVariant seen;
+
+    HttpServerRequestRouter router{
+        {QRegularExpression{"^/(\\w+)$"},
+         [](HttpServerRequest &request, HttpServerResponse&) -> bool {
+             request.setCustomData(QVariantMap{{"user", "declined"}});
+             return false;
+         }},
+        {QRegularExpression{"^/"},
+         [&seen](HttpServerRequest &request, HttpServerResponse&) -> bool {
+             seen = request.customData();
+             return true;
+         }}
+    };
+
+    LoopbackRequest loopback;
+    QVERIFY(loopback.send("GET /a HTTP/1.1\r\n"
+                          "Host: localhost\r\n"
+                          "\r\n"));
+    loopback.request->setCustomData(QVariantMap{{"session", 1}});
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    HttpServerResponse response{buffer, loopback.request->responseOptions()};
+    QVERIFY(router.handleRequest(*loopback.request, response));
+
+    // The declining handler's captures and custom data are both undone
+    QCOMPARE(seen.toMap(), (QVariantMap{{"session", 1}}));
+    QCOMPARE(loopback.request->routeParameters().size(), 0);
+}
+
+QTEST_GUILESS_MAIN(HttpServerRequestRouterTest)
@@ -5,4 +5,8 @@ class HttpServerRequestRouterTest: public QObject
     Q_OBJECT
 private slots:
     void mappings();
+    void cacheSize();
+    void methods();
+    void cacheInvalidation();
+    void customData();
 };
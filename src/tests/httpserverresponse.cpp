@@ -6,6 +6,19 @@
 
 using namespace Tufao;
 
+class WriteCounter: public QBuffer
+{
+public:
+    int writes = 0;
+
+protected:
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        ++writes;
+        return QBuffer::writeData(data, len);
+    }
+};
+
 void HttpServerResponseTest::statusCode_data()
 {
     QTest::addColumn<int>("statusCode");
@@ -236,4 +249,246 @@ void HttpServerResponseTest::invalid()
     }
 }
 
+void HttpServerResponseTest::singleWrite()
+{
+    WriteCounter buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    HttpServerResponse::Options options;
+    options |= HttpServerResponse::HTTP_1_1;
+    options |= HttpServerResponse::KEEP_ALIVE;
+    HttpServerResponse response{buffer, options};
+
+    for (int i = 0;i != 15;++i) {
+        response.headers().insert("X-Header-" + QByteArray::number(i),
+                                  "value");
+    }
+
+    QVERIFY(response.writeHead(HttpResponseStatus::OK));
+    QCOMPARE(buffer.writes, 0);
+
+    QVERIFY(response.end("Hello World\n"));
+    QCOMPARE(buffer.writes, 1);
+
+    QVERIFY(buffer.data().startsWith("HTTP/1.1 200 OK\r\n"));
+    QVERIFY(buffer.data().contains("X-Header-14: value\r\n"));
+    QVERIFY(buffer.data().endsWith("\r\n\r\nc\r\nHello World\n\r\n"
+                                   "0\r\n\r\n"));
+}
+
+void HttpServerResponseTest::dateHeader()
+{
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1
+                | HttpServerResponse::DATE_HEADER};
+
+        QVERIFY(response.writeHead(HttpResponseStatus::OK));
+        QVERIFY(response.end());
+
+        int begin = buffer.data().indexOf("\r\nDate: ");
+        QVERIFY(begin != -1);
+        begin += 8;
+        int end = buffer.data().indexOf("\r\n", begin);
+        QVERIFY(Headers::toDateTime(buffer.data().mid(begin, end - begin))
+                .isValid());
+    }
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1
+                | HttpServerResponse::DATE_HEADER};
+        response.headers().insert("Date", "Sun, 06 Nov 1994 08:49:37 GMT");
+
+        QVERIFY(response.writeHead(HttpResponseStatus::OK));
+        QVERIFY(response.end());
+
+        QCOMPARE(buffer.data().count("Date: "), 1);
+        QVERIFY(buffer.data().contains("\r\nDate: Sun, 06 Nov 1994 08:49:37"
+                                       " GMT\r\n"));
+    }
+}
+
+void HttpServerResponseTest::contentLength()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1
+            | HttpServerResponse::KEEP_ALIVE};
+    response.headers().insert("Content-Length", "11");
+
+    QVERIFY(response.writeHead(HttpResponseStatus::OK));
+    QVERIFY(response.write("Hello"));
+    QVERIFY(response.write(" World"));
+    QVERIFY(!response.addTrailer("X-Trailer", "value"));
+    QVERIFY(response.end());
+
+    QVERIFY(!buffer.data().contains("Transfer-Encoding"));
+    QVERIFY(buffer.data().contains("\r\nContent-Length: 11\r\n"));
+    QVERIFY(buffer.data().endsWith("\r\n\r\nHello World"));
+
+    {
+        // HTTP/1.0 bodies with a known length aren't buffered
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_0};
+        response.headers().insert("Content-Length", "11");
+
+        QVERIFY(response.writeHead(HttpResponseStatus::OK));
+        QVERIFY(response.write("Hello"));
+        QVERIFY(buffer.data().endsWith("\r\n\r\nHello"));
+        QVERIFY(response.write(" World"));
+        QVERIFY(buffer.data().endsWith("\r\n\r\nHello World"));
+        QVERIFY(response.end());
+
+        QVERIFY(buffer.data().startsWith("HTTP/1.0 200 OK\r\n"));
+        QCOMPARE(buffer.data().count("Content-Length"), 1);
+        QVERIFY(!buffer.data().contains("Connection"));
+        QVERIFY(!buffer.isOpen());
+    }
+}
+
+void HttpServerResponseTest::compression()
+{
+    QByteArray json("[");
+    for (int i = 0;i != 500;++i)
+        json += "{\"id\": " + QByteArray::number(i) + ", \"name\": \"item\"},";
+    json += "{}]";
+
+    Headers requestHeaders;
+    requestHeaders.insert("Accept-Encoding", "deflate, gzip;q=0.5");
+
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1
+                | HttpServerResponse::KEEP_ALIVE};
+        QVERIFY(response.enableCompression(requestHeaders));
+        response.headers().insert("Content-Type", "application/json");
+
+        QVERIFY(response.writeHead(HttpResponseStatus::OK));
+        QVERIFY(response.write(json.left(100)));
+        QVERIFY(response.write(json.mid(100)));
+        QVERIFY(response.end());
+
+        const QByteArray &data = buffer.data();
+        QVERIFY(data.contains("\r\nContent-Encoding: deflate\r\n"));
+        QVERIFY(data.contains("\r\nVary: Accept-Encoding\r\n"));
+        QVERIFY(!data.contains("Transfer-Encoding"));
+
+        QByteArray body(data.mid(data.indexOf("\r\n\r\n") + 4));
+        QVERIFY(data.contains("\r\nContent-Length: "
+                              + QByteArray::number(body.size()) + "\r\n"));
+
+        // qUncompress expects the size of the uncompressed data first
+        QByteArray size(4, '\0');
+        size[0] = char(json.size() >> 24);
+        size[1] = char(json.size() >> 16);
+        size[2] = char(json.size() >> 8);
+        size[3] = char(json.size());
+        QCOMPARE(qUncompress(size + body), json);
+    }
+    {
+        // Already compressed content isn't compressed again
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1};
+        QVERIFY(response.enableCompression(requestHeaders));
+        response.headers().insert("Content-Type", "image/png");
+
+        QVERIFY(response.writeHead(HttpResponseStatus::OK));
+        QVERIFY(response.end(json));
+
+        QVERIFY(!buffer.data().contains("Content-Encoding"));
+        QVERIFY(buffer.data().contains(json));
+    }
+    {
+        // Small bodies are sent as is
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1};
+        QVERIFY(response.enableCompression(requestHeaders));
+
+        QVERIFY(response.writeHead(HttpResponseStatus::OK));
+        QVERIFY(response.end("Hello World\n"));
+
+        QVERIFY(!buffer.data().contains("Content-Encoding"));
+        QVERIFY(buffer.data().endsWith("Hello World\n\r\n0\r\n\r\n"));
+    }
+    {
+        // Headers given to writeHead are taken into account
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1};
+        QVERIFY(response.enableCompression(requestHeaders));
+
+        Headers headers;
+        headers.insert("Content-Encoding", "gzip");
+        headers.insert("Content-Length", QByteArray::number(json.size()));
+        QVERIFY(response.writeHead(HttpResponseStatus::OK, headers));
+        QVERIFY(response.end(json));
+
+        const QByteArray &data = buffer.data();
+        QCOMPARE(data.count("Content-Encoding"), 1);
+        QCOMPARE(data.count("Content-Length"), 1);
+        QVERIFY(!data.contains("Transfer-Encoding"));
+        QVERIFY(data.endsWith("\r\n\r\n" + json));
+    }
+    {
+        // The compressed size replaces the Content-Length given to writeHead
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1};
+        QVERIFY(response.enableCompression(requestHeaders));
+
+        Headers headers;
+        headers.insert("Content-Length", QByteArray::number(json.size()));
+        QVERIFY(response.writeHead(HttpResponseStatus::OK, headers));
+        QVERIFY(response.write(json));
+        QVERIFY(response.end());
+
+        const QByteArray &data = buffer.data();
+        QVERIFY(data.contains("\r\nContent-Encoding: deflate\r\n"));
+        QCOMPARE(data.count("Content-Length"), 1);
+
+        QByteArray body(data.mid(data.indexOf("\r\n\r\n") + 4));
+        QVERIFY(data.contains("\r\nContent-Length: "
+                              + QByteArray::number(body.size()) + "\r\n"));
+    }
+    {
+        // Bodies announced beyond the compression window aren't buffered
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1};
+        QVERIFY(response.enableCompression(requestHeaders));
+        response.headers().insert("Content-Length",
+                                  QByteArray::number(1 << 21));
+
+        QVERIFY(response.writeHead(HttpResponseStatus::OK));
+        QVERIFY(response.write(json));
+        QVERIFY(buffer.data().endsWith("\r\n\r\n" + json));
+        QVERIFY(!buffer.data().contains("Content-Encoding"));
+    }
+    {
+        Headers identity;
+        identity.insert("Accept-Encoding", "identity, gzip;q=0");
+
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        HttpServerResponse response{buffer, HttpServerResponse::HTTP_1_1};
+        QVERIFY(!response.enableCompression(identity));
+    }
+}
+
 QTEST_APPLESS_MAIN(HttpServerResponseTest)
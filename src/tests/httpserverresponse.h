@@ -15,4 +15,8 @@ private slots:
     void httpContinue();
     void options();
     void invalid();
+    void singleWrite();
+    void dateHeader();
+    void contentLength();
+    void compression();
 };
@@ -1,7 +1,11 @@
 #include "httpupgraderouter.h"
+#include "loopback.h"
 #include <QtTest/QTest>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
 #include "../httpupgraderouter.h"
+#include "../routeparameters.h"
 
 using namespace Tufao;
 
@@ -55,4 +59,60 @@ void HttpUpgradeRouterTest::mappings()
             }), 1);
 }
 
-QTEST_APPLESS_MAIN(HttpUpgradeRouterTest)
+void HttpUpgradeRouterTest::mapRange()
+{
+    HttpUpgradeRouter::Handler handler{[](HttpServerRequest&,
+                                          const QByteArray&) {
+        return true;
+    }};
+
+    HttpUpgradeRouter httpUpgradeRouter;
+    QCOMPARE(httpUpgradeRouter.map({QRegularExpression{}, handler}), 0);
+
+    std::initializer_list<HttpUpgradeRouter::Mapping> range{
+        {QRegularExpression{"^/a$"}, handler},
+        {QRegularExpression{"^/b$"}, handler}
+    };
+    QCOMPARE(httpUpgradeRouter.map(range), 1);
+    QCOMPARE(httpUpgradeRouter.map({QRegularExpression{}, handler}), 3);
+}
+
+void HttpUpgradeRouterTest::routeParameters()
+{
+    QStringList parameters;
+    QStringList args;
+    QString room;
+
+    HttpUpgradeRouter inner{
+        {QRegularExpression{"^/chat/(\\w+)$"},
+         [](HttpServerRequest&, const QByteArray&) { return false; }},
+        {QRegularExpression{"^/(\\w+)/(?<room>\\w+)$"},
+         [&](HttpServerRequest &request, const QByteArray&) -> bool {
+             parameters = request.routeParameters().toStringList();
+             args = request.customData().toMap()["args"].toStringList();
+             room = request.routeParameters().value("room").toString();
+             return true;
+         }}
+    };
+
+    HttpUpgradeRouter outer{
+        {QRegularExpression{"^/(\\w+)/"},
+         [&inner](HttpServerRequest &request, const QByteArray &head) {
+             return inner.handleUpgrade(request, head);
+         }}
+    };
+
+    LoopbackRequest loopback;
+    QVERIFY(loopback.send("GET /chat/general HTTP/1.1\r\n"
+                          "Host: localhost\r\n"
+                          "\r\n"));
+    QVERIFY(outer.handleUpgrade(*loopback.request, QByteArray{}));
+
+    // The outer capture survives the inner captures and the declined handler
+    const QStringList expected{"chat", "chat", "general"};
+    QCOMPARE(parameters, expected);
+    QCOMPARE(args, expected);
+    QCOMPARE(room, QString{"general"});
+}
+
+QTEST_GUILESS_MAIN(HttpUpgradeRouterTest)
@@ -5,4 +5,6 @@ class HttpUpgradeRouterTest: public QObject
     Q_OBJECT
 private slots:
     void mappings();
+    void mapRange();
+    void routeParameters();
 };
@@ -76,4 +76,95 @@ void IByteArrayTest::caseInsensitivity()
     QVERIFY(!(ibytearray2 != ibytearray2));
 }
 
+void IByteArrayTest::hash_data()
+{
+    // qbytearray1 == qbytearray2
+    QTest::addColumn<QByteArray>("qbytearray1");
+    QTest::addColumn<QByteArray>("qbytearray2");
+
+    QTest::newRow("empty") << QByteArray{} << QByteArray{""};
+    QTest::newRow("Host and HOST") << QByteArray{"Host"}
+        << QByteArray{"HOST"};
+    QTest::newRow("Content-Type and content-type")
+        << QByteArray{"Content-Type"} << QByteArray{"content-type"};
+    QTest::newRow("Sec-WebSocket-Extensions and sec-websocket-extensions")
+        << QByteArray{"Sec-WebSocket-Extensions"}
+        << QByteArray{"sec-websocket-extensions"};
+    QTest::newRow("Latin-1") << QByteArray{"X-\xc0\xc9\xde-Header"}
+        << QByteArray{"x-\xe0\xe9\xfe-header"};
+}
+
+void IByteArrayTest::hash()
+{
+    QFETCH(QByteArray, qbytearray1);
+    QFETCH(QByteArray, qbytearray2);
+
+    const IByteArray ibytearray1 = qbytearray1;
+    const IByteArray ibytearray2 = qbytearray2;
+
+    QVERIFY(ibytearray1 == ibytearray2);
+    QCOMPARE(qHash(ibytearray1), qHash(ibytearray2));
+    QCOMPARE(qHash(ibytearray1, 42), qHash(ibytearray2, 42));
+
+    // Code built against Tufão 1.4 inlined this hash
+    QCOMPARE(qHash(ibytearray1), ::qHash(qbytearray1.toLower()));
+    QCOMPARE(qHash(ibytearray2, 42), ::qHash(qbytearray2.toLower()) ^ 42u);
+    const QByteArray longName(300, 'X');
+    QCOMPARE(qHash(IByteArray(longName)), ::qHash(longName.toLower()));
+
+    // Differences past the first word must be noticed too
+    const IByteArray different = qbytearray1 + "-";
+    QVERIFY(ibytearray1 != different);
+    QVERIFY(!caseInsensitiveEqual("Sec-WebSocket-Key",
+                                  "Sec-WebSocket-Kez", 17));
+}
+
+void IByteArrayTest::benchmark_data()
+{
+    QTest::addColumn<QByteArray>("qbytearray1");
+    QTest::addColumn<QByteArray>("qbytearray2");
+    QTest::addColumn<bool>("qstricmp");
+
+    const QByteArray names[][2] = {
+        {"TE", "te"},
+        {"Host", "host"},
+        {"Content-Type", "content-type"},
+        {"Accept-Encoding", "accept-encoding"},
+        {"If-Unmodified-Since", "if-unmodified-since"},
+        {"Sec-WebSocket-Extensions", "sec-websocket-extensions"}
+    };
+
+    for (const auto &name: names) {
+        QTest::newRow((name[0] + ", word-at-a-time").constData())
+            << name[0] << name[1] << false;
+        QTest::newRow((name[0] + ", qstricmp and toLower").constData())
+            << name[0] << name[1] << true;
+    }
+}
+
+void IByteArrayTest::benchmark()
+{
+    QFETCH(QByteArray, qbytearray1);
+    QFETCH(QByteArray, qbytearray2);
+    QFETCH(bool, qstricmp);
+
+    const IByteArray ibytearray1 = qbytearray1;
+    const IByteArray ibytearray2 = qbytearray2;
+
+    // The qstricmp path mirrors what IByteArray used to do
+    if (qstricmp) {
+        QBENCHMARK {
+            QVERIFY(::qstricmp(ibytearray1.constData(),
+                               ibytearray2.constData()) == 0);
+            QCOMPARE(::qHash(ibytearray1.toLower()),
+                     ::qHash(ibytearray2.toLower()));
+        }
+    } else {
+        QBENCHMARK {
+            QVERIFY(ibytearray1 == ibytearray2);
+            QCOMPARE(qHash(ibytearray1), qHash(ibytearray2));
+        }
+    }
+}
+
 QTEST_APPLESS_MAIN(IByteArrayTest)
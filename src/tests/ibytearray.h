@@ -8,4 +8,8 @@ private slots:
     void relational();
     void caseInsensitivity_data();
     void caseInsensitivity();
+    void hash_data();
+    void hash();
+    void benchmark_data();
+    void benchmark();
 };
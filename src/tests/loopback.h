@@ -0,0 +1,122 @@
+#include <QtCore/QScopedPointer>
+#include <QtTest/QSignalSpy>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include "../httpserverrequest.h"
+#include "../websocket.h"
+#include "../priv/websocketframe.h"
+
+// A request parsed from a loopback connection, like HttpServer provides them
+struct LoopbackRequest
+{
+    // Sends message and waits for signal (the ready signal by default). Call
+    // it only once.
+    bool send(const QByteArray &message, const char *signal = SIGNAL(ready()))
+    {
+        if (!listener.listen(QHostAddress::LocalHost))
+            return false;
+
+        client.connectToHost(QHostAddress::LocalHost, listener.serverPort());
+        if (!listener.waitForNewConnection(5000))
+            return false;
+
+        request.reset(new Tufao::HttpServerRequest(*listener
+                                                   .nextPendingConnection()));
+        QSignalSpy spy(request.data(), signal);
+        client.write(message);
+        return spy.wait();
+    }
+
+    QTcpServer listener;
+    QTcpSocket client;
+    QScopedPointer<Tufao::HttpServerRequest> request;
+};
+
+// A server WebSocket accepted from a loopback connection. The client end is a
+// raw socket, so the tests see and control the exact bytes on the wire.
+struct LoopbackWebSocket
+{
+    // Sends the opening handshake plus extraHeaders and reads the response of
+    // the server, which is kept in handshake. Call it only once.
+    bool open(const QByteArray &extraHeaders = QByteArray())
+    {
+        if (!loopback.send("GET /chat HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                           "Sec-WebSocket-Version: 13\r\n"
+                           + extraHeaders + "\r\n", SIGNAL(upgrade()))) {
+            return false;
+        }
+
+        if (!websocket.startServerHandshake(*loopback.request))
+            return false;
+
+        int end;
+        while ((end = received.indexOf("\r\n\r\n")) == -1) {
+            if (!wait())
+                return false;
+        }
+
+        handshake = received.left(end + 4);
+        received.remove(0, end + 4);
+        return handshake.startsWith("HTTP/1.1 101 ");
+    }
+
+    // Writes data to the server and waits until the server socket gets it
+    bool write(const QByteArray &data)
+    {
+        QSignalSpy readyRead(&loopback.request->socket(),
+                             SIGNAL(readyRead()));
+        loopback.client.write(data);
+        return readyRead.wait();
+    }
+
+    // Reads exactly size bytes sent by the server
+    QByteArray read(int size)
+    {
+        while (received.size() < size) {
+            if (!wait())
+                break;
+        }
+
+        QByteArray data = received.left(size);
+        received.remove(0, data.size());
+        return data;
+    }
+
+    // Waits for more bytes from the server
+    bool wait()
+    {
+        if (!loopback.client.bytesAvailable()) {
+            QSignalSpy readyRead(&loopback.client, SIGNAL(readyRead()));
+            if (!readyRead.wait())
+                return false;
+        }
+
+        received += loopback.client.readAll();
+        return true;
+    }
+
+    LoopbackRequest loopback;
+    Tufao::WebSocket websocket;
+    QByteArray handshake;
+    QByteArray received;
+};
+
+// Encodes a frame masked like the ones sent by client nodes
+inline QByteArray clientFrame(quint8 firstByte, const QByteArray &payload)
+{
+    static const quint8 key[4] = {0x37, 0xfa, 0x21, 0x3d};
+
+    char header[Tufao::MAX_FRAME_HEADER_SIZE];
+    const int size = Tufao::encodeFrameHeader(header, firstByte,
+                                              payload.size(), key);
+
+    QByteArray masked(payload);
+    quint8 index = 0;
+    Tufao::maskPayload(masked.data(), masked.size(), key, index);
+
+    return QByteArray(header, size) + masked;
+}
@@ -0,0 +1,324 @@
+#include "permessagedeflate.h"
+#include <QtTest/QTest>
+#include "../priv/permessagedeflate.h"
+#include "../priv/contentcoding.h"
+
+using namespace Tufao;
+
+static QByteArray jsonMessage(int records)
+{
+    QByteArray message("[");
+    for (int i = 0;i != records;++i) {
+        if (i)
+            message += ',';
+
+        message += "{\"id\":" + QByteArray::number(i)
+            + ",\"name\":\"user" + QByteArray::number(i * 7919 % 1000)
+            + "\",\"online\":" + (i % 3 ? "true" : "false")
+            + ",\"score\":" + QByteArray::number(i * 31 % 977) + '}';
+    }
+    message += ']';
+    return message;
+}
+
+void PerMessageDeflateTest::inflate_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QByteArray binary(70000, Qt::Uninitialized);
+    quint32 seed = 1;
+    for (int i = 0;i != binary.size();++i) {
+        seed = seed * 1103515245 + 12345;
+        binary[i] = char(seed >> 24);
+    }
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("text") << QByteArray("Hello");
+    QTest::newRow("repetitive") << QByteArray(100000, 'a');
+    QTest::newRow("json") << jsonMessage(1000);
+    QTest::newRow("binary") << binary;
+}
+
+void PerMessageDeflateTest::inflate()
+{
+    QFETCH(QByteArray, data);
+
+    const QByteArray deflated = rawDeflate(data);
+
+    QByteArray out;
+    QVERIFY(rawInflate(deflated.constData(), deflated.size(), out,
+                       data.size()));
+    QCOMPARE(out, data);
+
+    // The history is preserved and the limit covers it
+    out = "history";
+    QVERIFY(rawInflate(deflated.constData(), deflated.size(), out,
+                       data.size() + 7));
+    QCOMPARE(out, "history" + data);
+
+    if (data.size()) {
+        out.clear();
+        QVERIFY(!rawInflate(deflated.constData(), deflated.size(), out,
+                            data.size() - 1));
+
+        out.clear();
+        QVERIFY(!rawInflate(deflated.constData(), deflated.size() - 1, out,
+                            data.size()));
+    }
+}
+
+void PerMessageDeflateTest::history()
+{
+    // RFC 7692, section 7.2.3.2: the second message references the first
+    PerMessageDeflate deflate;
+
+    QByteArray message("\xf2\x48\xcd\xc9\xc9\x07\x00", 7);
+    QVERIFY(deflate.inflate(message));
+    QCOMPARE(message, QByteArray("Hello"));
+
+    message = QByteArray("\xf2\x00\x11\x00\x00", 5);
+    QVERIFY(deflate.inflate(message));
+    QCOMPARE(message, QByteArray("Hello"));
+
+    // Without context takeover, the reference points to nothing
+    deflate.reset();
+    deflate.peerNoContextTakeover = true;
+
+    message = QByteArray("\xf2\x48\xcd\xc9\xc9\x07\x00", 7);
+    QVERIFY(deflate.inflate(message));
+    message = QByteArray("\xf2\x00\x11\x00\x00", 5);
+    QVERIFY(!deflate.inflate(message));
+
+    // A final block (section 7.2.3.3) and a stored block (section 7.2.3.4)
+    message = QByteArray("\xf3\x48\xcd\xc9\xc9\x07\x00\x00", 8);
+    QVERIFY(deflate.inflate(message));
+    QCOMPARE(message, QByteArray("Hello"));
+
+    message = QByteArray("\x00\x05\x00\xfa\xff\x48\x65\x6c\x6c\x6f\x00", 11);
+    QVERIFY(deflate.inflate(message));
+    QCOMPARE(message, QByteArray("Hello"));
+}
+
+void PerMessageDeflateTest::negotiate_data()
+{
+    QTest::addColumn<QByteArray>("offer");
+    QTest::addColumn<int>("memoryLimit");
+    QTest::addColumn<QByteArray>("response");
+
+    QTest::newRow("no offer") << QByteArray() << 32768 << QByteArray();
+    QTest::newRow("unknown extension")
+        << QByteArray("x-webkit-deflate-frame") << 32768 << QByteArray();
+    QTest::newRow("unknown parameter")
+        << QByteArray("permessage-deflate; foo") << 32768 << QByteArray();
+    QTest::newRow("invalid window")
+        << QByteArray("permessage-deflate; server_max_window_bits=7")
+        << 32768 << QByteArray();
+    QTest::newRow("plain")
+        << QByteArray("permessage-deflate") << 32768
+        << QByteArray("permessage-deflate; server_no_context_takeover");
+    QTest::newRow("second offer")
+        << QByteArray("permessage-deflate; client_max_window_bits=16,"
+                      " permessage-deflate; client_max_window_bits")
+        << 32768
+        << QByteArray("permessage-deflate; server_no_context_takeover");
+    QTest::newRow("server window")
+        << QByteArray("permessage-deflate; server_max_window_bits=\"10\"")
+        << 32768
+        << QByteArray("permessage-deflate; server_no_context_takeover;"
+                      " server_max_window_bits=10");
+    QTest::newRow("limited client window")
+        << QByteArray("permessage-deflate; client_max_window_bits") << 4096
+        << QByteArray("permessage-deflate; server_no_context_takeover;"
+                      " client_max_window_bits=12");
+    QTest::newRow("smaller client window")
+        << QByteArray("permessage-deflate; client_max_window_bits=10") << 4096
+        << QByteArray("permessage-deflate; server_no_context_takeover;"
+                      " client_max_window_bits=10");
+    QTest::newRow("unlimited client window") << QByteArray("permessage-deflate")
+        << 4096
+        << QByteArray("permessage-deflate; server_no_context_takeover;"
+                      " client_no_context_takeover");
+    QTest::newRow("tiny limit")
+        << QByteArray("permessage-deflate; client_max_window_bits") << 100
+        << QByteArray("permessage-deflate; server_no_context_takeover;"
+                      " client_no_context_takeover");
+}
+
+void PerMessageDeflateTest::negotiate()
+{
+    QFETCH(QByteArray, offer);
+    QFETCH(int, memoryLimit);
+    QFETCH(QByteArray, response);
+
+    Headers headers;
+    if (offer.size())
+        headers.insert("Sec-WebSocket-Extensions", offer);
+
+    PerMessageDeflate deflate;
+    deflate.memoryLimit = memoryLimit;
+    QVERIFY(deflate.negotiate(headers).isEmpty());
+    QVERIFY(!deflate.active);
+
+    deflate.enabled = true;
+    QCOMPARE(deflate.negotiate(headers), response);
+    QCOMPARE(deflate.active, !response.isEmpty());
+}
+
+void PerMessageDeflateTest::acceptResponse_data()
+{
+    QTest::addColumn<int>("memoryLimit");
+    QTest::addColumn<QByteArray>("response");
+    QTest::addColumn<bool>("accepted");
+    QTest::addColumn<bool>("active");
+
+    QTest::newRow("declined") << 32768 << QByteArray() << true << false;
+    QTest::newRow("plain")
+        << 32768 << QByteArray("permessage-deflate") << true << true;
+    QTest::newRow("client window")
+        << 32768 << QByteArray("permessage-deflate; client_max_window_bits=9")
+        << true << true;
+    QTest::newRow("client window without value")
+        << 32768 << QByteArray("permessage-deflate; client_max_window_bits")
+        << false << false;
+    QTest::newRow("two extensions")
+        << 32768 << QByteArray("permessage-deflate, permessage-deflate")
+        << false << false;
+    QTest::newRow("ignored limit")
+        << 4096 << QByteArray("permessage-deflate") << false << false;
+    QTest::newRow("bigger window")
+        << 4096 << QByteArray("permessage-deflate; server_max_window_bits=13")
+        << false << false;
+    QTest::newRow("honoured limit")
+        << 4096 << QByteArray("permessage-deflate; server_max_window_bits=12")
+        << true << true;
+    QTest::newRow("no context takeover")
+        << 100 << QByteArray("permessage-deflate; server_no_context_takeover")
+        << true << true;
+}
+
+void PerMessageDeflateTest::acceptResponse()
+{
+    QFETCH(int, memoryLimit);
+    QFETCH(QByteArray, response);
+    QFETCH(bool, accepted);
+    QFETCH(bool, active);
+
+    QList<QByteArray> values;
+    if (response.size())
+        values.push_back(response);
+
+    PerMessageDeflate deflate;
+    deflate.enabled = true;
+    deflate.memoryLimit = memoryLimit;
+    QVERIFY(deflate.offer().startsWith("permessage-deflate;"));
+
+    QCOMPARE(deflate.acceptResponse(values), accepted);
+    QCOMPARE(deflate.active, active);
+
+    // Responses to offers never sent are never accepted
+    deflate.reset();
+    QCOMPARE(deflate.acceptResponse(values), response.isEmpty());
+}
+
+void PerMessageDeflateTest::roundTrip()
+{
+    PerMessageDeflate client;
+    PerMessageDeflate server;
+    client.enabled = true;
+    server.enabled = true;
+
+    Headers request;
+    request.insert("Sec-WebSocket-Extensions", client.offer());
+    QList<QByteArray> response;
+    response.push_back(server.negotiate(request));
+    QVERIFY(client.acceptResponse(response));
+
+    const QByteArray message = jsonMessage(100);
+
+    QByteArray compressed;
+    QVERIFY(client.compress(message, compressed));
+    QVERIFY(compressed.size() < message.size());
+    QVERIFY(server.inflate(compressed));
+    QCOMPARE(compressed, message);
+
+    QVERIFY(server.compress(message, compressed));
+    QVERIFY(client.inflate(compressed));
+    QCOMPARE(compressed, message);
+
+    // Not worth it
+    QVERIFY(!client.compress("Hello", compressed));
+}
+
+void PerMessageDeflateTest::accepts_data()
+{
+    QTest::addColumn<int>("windowBits");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("accepted");
+
+    QTest::newRow("too small") << 15 << 63 << false;
+    QTest::newRow("smallest") << 15 << 64 << true;
+    QTest::newRow("largest window") << 15 << 70000 << true;
+    QTest::newRow("fits the window") << 9 << 512 << true;
+    QTest::newRow("bigger than the window") << 9 << 513 << false;
+}
+
+void PerMessageDeflateTest::accepts()
+{
+    QFETCH(int, windowBits);
+    QFETCH(int, size);
+    QFETCH(bool, accepted);
+
+    PerMessageDeflate deflate;
+    QVERIFY(!deflate.accepts(size));
+
+    deflate.active = true;
+    deflate.windowBits = windowBits;
+    QCOMPARE(deflate.accepts(size), accepted);
+}
+
+void PerMessageDeflateTest::benchmark_data()
+{
+    QTest::addColumn<int>("records");
+    QTest::addColumn<bool>("compressed");
+
+    for (int records: {10, 100, 1000}) {
+        const QByteArray name = QByteArray::number(records) + " records";
+        QTest::newRow((name + ", compressed").constData()) << records << true;
+        QTest::newRow((name + ", uncompressed").constData())
+            << records << false;
+    }
+}
+
+void PerMessageDeflateTest::benchmark()
+{
+    QFETCH(int, records);
+    QFETCH(bool, compressed);
+
+    PerMessageDeflate sender;
+    PerMessageDeflate receiver;
+    sender.active = compressed;
+    receiver.active = compressed;
+
+    const QByteArray message = jsonMessage(records);
+
+    // Sender and receiver CPU time, the bytes on the wire are reported below
+    int wireSize = message.size();
+    QBENCHMARK {
+        QByteArray payload;
+        const bool deflated = sender.compress(message, payload);
+        QCOMPARE(deflated, compressed);
+
+        if (deflated) {
+            wireSize = payload.size();
+            QVERIFY(receiver.inflate(payload));
+        } else {
+            payload = message;
+        }
+        QCOMPARE(payload.size(), message.size());
+    }
+
+    qDebug("%d bytes on the wire (%d bytes of JSON)", wireSize,
+           message.size());
+}
+
+QTEST_APPLESS_MAIN(PerMessageDeflateTest)
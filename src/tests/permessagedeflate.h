@@ -0,0 +1,19 @@
+#include <QtCore/QObject>
+
+class PerMessageDeflateTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void inflate_data();
+    void inflate();
+    void history();
+    void negotiate_data();
+    void negotiate();
+    void acceptResponse_data();
+    void acceptResponse();
+    void roundTrip();
+    void accepts_data();
+    void accepts();
+    void benchmark_data();
+    void benchmark();
+};
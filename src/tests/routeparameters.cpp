@@ -0,0 +1,67 @@
+#include "routeparameters.h"
+#include <QtTest/QTest>
+#include "../routeparameters.h"
+
+using namespace Tufao;
+
+void RouteParametersTest::positional()
+{
+    const QString path{"/user/42/posts/7"};
+
+    RouteParameters parameters;
+    QVERIFY(parameters.isEmpty());
+
+    parameters.append(path, 6, 2);
+    parameters.append(path, 15, 1);
+    parameters.append(path, -1, 0);
+
+    QCOMPARE(parameters.size(), 3);
+    QCOMPARE(parameters[0].toString(), QString{"42"});
+    QCOMPARE(parameters.at(1).toString(), QString{"7"});
+    QVERIFY(parameters[2].isNull());
+    QCOMPARE(parameters[0].position(), 6);
+    QCOMPARE(parameters.toStringList(),
+             (QStringList{"42", "7", QString{}}));
+}
+
+void RouteParametersTest::named()
+{
+    const QString outer{"/api/v1/user/vini"};
+    const QString inner{"/user/vini"};
+
+    RouteParameters parameters;
+    parameters.append(outer, 5, 2, "version");
+    parameters.append(outer, 13, 4, "name");
+    parameters.append(inner, 6, 4, "name");
+    parameters.append(inner, 6, 4);
+
+    QCOMPARE(parameters.name(0), QString{"version"});
+    QVERIFY(parameters.name(3).isNull());
+    QCOMPARE(parameters.value("version").toString(), QString{"v1"});
+    QCOMPARE(parameters.indexOf("name"), 2);
+    QCOMPARE(parameters.value("name").toString(), QString{"vini"});
+    QCOMPARE(parameters.indexOf("missing"), -1);
+    QVERIFY(parameters.value("missing").isNull());
+}
+
+void RouteParametersTest::truncate()
+{
+    const QString path{"/a/b/c/d/e/f"};
+
+    RouteParameters parameters;
+    for (int i = 1;i < path.size();i += 2)
+        parameters.append(path, i, 1);
+    QCOMPARE(parameters.size(), 6);
+
+    parameters.truncate(8);
+    QCOMPARE(parameters.size(), 6);
+
+    parameters.truncate(2);
+    QCOMPARE(parameters.size(), 2);
+    QCOMPARE(parameters[1].toString(), QString{"b"});
+
+    parameters.clear();
+    QVERIFY(parameters.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(RouteParametersTest)
@@ -0,0 +1,10 @@
+#include <QtCore/QObject>
+
+class RouteParametersTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void positional();
+    void named();
+    void truncate();
+};
@@ -0,0 +1,102 @@
+#include "routetree.h"
+#include <QtTest/QTest>
+#include "../priv/routetree.h"
+
+using namespace Tufao;
+
+void RouteTreeTest::compile_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("compiled");
+
+    QTest::newRow("empty") << QString{} << true;
+    QTest::newRow("literal") << QString{"^/about$"} << true;
+    QTest::newRow("escaped") << QString{"^/index\\.html$"} << true;
+    QTest::newRow("segment") << QString{"^/user/([^/]+)$"} << true;
+    QTest::newRow("named") << QString{"^/user/(?<id>\\d+)/posts$"} << true;
+    QTest::newRow("tail") << QString{"^/static/(.*)$"} << true;
+    QTest::newRow("prefix") << QString{"^/api"} << true;
+    QTest::newRow("unanchored") << QString{"/api"} << false;
+    QTest::newRow("alternation") << QString{"^/(a|b)$"} << false;
+    QTest::newRow("partial segment") << QString{"^/([^/]+)\\.json$"} << false;
+    QTest::newRow("quantifier") << QString{"^/a+$"} << false;
+}
+
+void RouteTreeTest::compile()
+{
+    QFETCH(QString, pattern);
+    QFETCH(bool, compiled);
+
+    RouteTree tree;
+    QCOMPARE(tree.insert(QRegularExpression{pattern}, 0), compiled);
+}
+
+void RouteTreeTest::match_data()
+{
+    QTest::addColumn<QString>("path");
+
+    QTest::newRow("root") << QString{"/"};
+    QTest::newRow("empty") << QString{};
+    QTest::newRow("about") << QString{"/about"};
+    QTest::newRow("about with newline") << QString{"/about\n"};
+    QTest::newRow("about with slash") << QString{"/about/"};
+    QTest::newRow("user") << QString{"/user/vinipsmaker"};
+    QTest::newRow("numeric user") << QString{"/user/42"};
+    QTest::newRow("posts") << QString{"/user/42/posts"};
+    QTest::newRow("named posts") << QString{"/user/vini/posts"};
+    QTest::newRow("static") << QString{"/static/css/main.css"};
+    QTest::newRow("static dir") << QString{"/static/"};
+    QTest::newRow("api") << QString{"/api/v1/users"};
+    QTest::newRow("apis") << QString{"/apis"};
+    QTest::newRow("index") << QString{"/index.html"};
+    QTest::newRow("index like") << QString{"/indexxhtml"};
+}
+
+void RouteTreeTest::match()
+{
+    QFETCH(QString, path);
+
+    const QVector<QRegularExpression> patterns{
+        QRegularExpression{},
+        QRegularExpression{"^/$"},
+        QRegularExpression{"^/about$"},
+        QRegularExpression{"^/index\\.html$"},
+        QRegularExpression{"^/user/([^/]+)$"},
+        QRegularExpression{"^/user/(\\d+)$"},
+        QRegularExpression{"^/user/(?<id>\\w+)/posts$"},
+        QRegularExpression{"^/static/(.*)$"},
+        QRegularExpression{"^/static/(.+)$"},
+        QRegularExpression{"^/api"},
+        QRegularExpression{"^/api/([^/]+)/(.*)"},
+        QRegularExpression{"^/([0-9]+)/"}
+    };
+
+    RouteTree tree;
+    for (int i = 0;i != patterns.size();++i)
+        QVERIFY(tree.insert(patterns[i], i));
+
+    QVector<RouteTree::Match> matches;
+    tree.match(path, matches);
+
+    // The tree must agree with the regexes
+    auto match = matches.cbegin();
+    for (int i = 0;i != patterns.size();++i) {
+        QRegularExpressionMatch expected{patterns[i].match(path)};
+        if (!expected.hasMatch())
+            continue;
+
+        QVERIFY(match != matches.cend());
+        QCOMPARE(match->index, i);
+        QCOMPARE(match->captures.size(), expected.lastCapturedIndex());
+
+        for (int j = 0;j != match->captures.size();++j) {
+            QCOMPARE(match->captures[j].begin, expected.capturedStart(j + 1));
+            QCOMPARE(match->captures[j].size, expected.capturedLength(j + 1));
+        }
+
+        ++match;
+    }
+    QVERIFY(match == matches.cend());
+}
+
+QTEST_APPLESS_MAIN(RouteTreeTest)
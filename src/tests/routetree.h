@@ -0,0 +1,11 @@
+#include <QtCore/QObject>
+
+class RouteTreeTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void compile_data();
+    void compile();
+    void match_data();
+    void match();
+};
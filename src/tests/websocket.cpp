@@ -1,6 +1,8 @@
 #include "websocket.h"
+#include "loopback.h"
 #include <QtTest/QTest>
 #include "../websocket.h"
+#include "../priv/permessagedeflate.h"
 
 using namespace Tufao;
 
@@ -17,4 +19,105 @@ void WebSocketTest::properties()
     QCOMPARE(websocket.messagesType(), WebSocketMessageType::BINARY_MESSAGE);
 }
 
-QTEST_APPLESS_MAIN(WebSocketTest)
+void WebSocketTest::parser_data()
+{
+    QTest::addColumn<int>("chunk");
+
+    QTest::newRow("byte by byte") << 1;
+    QTest::newRow("odd pieces") << 7;
+    QTest::newRow("pieces across frames") << 4093;
+    QTest::newRow("bulk") << 0;
+}
+
+void WebSocketTest::parser()
+{
+    QFETCH(int, chunk);
+
+    LoopbackWebSocket peer;
+    QVERIFY(peer.open());
+    QSignalSpy messages(&peer.websocket, SIGNAL(newMessage(QByteArray)));
+
+    const QByteArray medium(300, 'm');
+    QByteArray large(65536 + 3, Qt::Uninitialized);
+    for (int i = 0;i != large.size();++i)
+        large[i] = char(i % 251);
+
+    // Pipelined frames with 7-bit, 16-bit and 64-bit payload lengths, a
+    // fragmented message and an empty one
+    QByteArray stream = clientFrame(0x81, "Hello")
+        + clientFrame(0x82, medium)
+        + clientFrame(0x01, "frag")
+        + clientFrame(0x80, "mented");
+    const int largeBegin = stream.size();
+    stream += clientFrame(0x82, large);
+    const int largeEnd = stream.size();
+    stream += clientFrame(0x82, QByteArray());
+
+    if (!chunk) {
+        QVERIFY(peer.write(stream));
+    } else {
+        // The masking key phase spans reads whenever chunk isn't a multiple
+        // of 4. The bulk of the large payload goes in bigger pieces to keep
+        // the test fast.
+        for (int i = 0;i < stream.size();) {
+            int size = chunk;
+            if (i >= largeBegin + 16 && i < largeEnd)
+                size = qMin(qMax(chunk, 4093), largeEnd - i);
+
+            QVERIFY(peer.write(stream.mid(i, size)));
+            i += size;
+        }
+    }
+
+    QTRY_COMPARE(messages.size(), 5);
+    QCOMPARE(messages[0][0].toByteArray(), QByteArray("Hello"));
+    QCOMPARE(messages[1][0].toByteArray(), medium);
+    QCOMPARE(messages[2][0].toByteArray(), QByteArray("fragmented"));
+    QCOMPARE(messages[3][0].toByteArray(), large);
+    QCOMPARE(messages[4][0].toByteArray(), QByteArray());
+
+    QCOMPARE(int(peer.websocket.error()), 0);
+    QVERIFY(peer.loopback.client.state() == QAbstractSocket::ConnectedState);
+}
+
+void WebSocketTest::rsv1WithoutExtension()
+{
+    LoopbackWebSocket peer;
+    peer.websocket.setPermessageDeflate(true);
+    QVERIFY(peer.open());
+    QVERIFY(!peer.handshake.contains("Sec-WebSocket-Extensions"));
+    QVERIFY(!peer.websocket.isPermessageDeflateActive());
+
+    QSignalSpy messages(&peer.websocket, SIGNAL(newMessage(QByteArray)));
+    QSignalSpy disconnected(&peer.loopback.client, SIGNAL(disconnected()));
+
+    // RSV1 is only valid when permessage-deflate was negotiated
+    QVERIFY(peer.write(clientFrame(0xc1, "Hello")));
+
+    QCOMPARE(peer.read(4), QByteArray("\x88\x02\x03\xea"));
+    QVERIFY(disconnected.count() || disconnected.wait());
+    QCOMPARE(messages.count(), 0);
+    QCOMPARE(peer.websocket.error(), WebSocketError::WEBSOCKET_PROTOCOL_ERROR);
+}
+
+void WebSocketTest::compressedMessage()
+{
+    LoopbackWebSocket peer;
+    peer.websocket.setPermessageDeflate(true);
+    QVERIFY(peer.open("Sec-WebSocket-Extensions: permessage-deflate\r\n"));
+    QVERIFY(peer.handshake.contains("Sec-WebSocket-Extensions: "
+                                    "permessage-deflate"));
+    QVERIFY(peer.websocket.isPermessageDeflateActive());
+
+    QSignalSpy messages(&peer.websocket, SIGNAL(newMessage(QByteArray)));
+
+    const QByteArray message(1000, 'x');
+    const QByteArray payload = PerMessageDeflate::deflate(message);
+    QVERIFY(!payload.isNull());
+
+    QVERIFY(peer.write(clientFrame(0xc1, payload)));
+    QTRY_COMPARE(messages.count(), 1);
+    QCOMPARE(messages[0][0].toByteArray(), message);
+}
+
+QTEST_GUILESS_MAIN(WebSocketTest)
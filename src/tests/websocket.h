@@ -5,4 +5,8 @@ class WebSocketTest: public QObject
     Q_OBJECT
 private slots:
     void properties();
+    void parser_data();
+    void parser();
+    void rsv1WithoutExtension();
+    void compressedMessage();
 };
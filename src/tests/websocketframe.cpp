@@ -0,0 +1,103 @@
+#include "websocketframe.h"
+#include <QtTest/QTest>
+#include "../priv/websocketframe.h"
+
+using namespace Tufao;
+
+void WebSocketFrameTest::encodeHeader_data()
+{
+    QTest::addColumn<quint64>("payloadSize");
+    QTest::addColumn<bool>("masked");
+    QTest::addColumn<QByteArray>("header");
+
+    QTest::newRow("empty")
+        << quint64{0} << false << QByteArray{"\x81\x00", 2};
+    QTest::newRow("7-bit length")
+        << quint64{125} << false << QByteArray{"\x81\x7d"};
+    QTest::newRow("16-bit length")
+        << quint64{126} << false << QByteArray{"\x81\x7e\x00\x7e", 4};
+    QTest::newRow("largest 16-bit length")
+        << quint64{65535} << false << QByteArray{"\x81\x7e\xff\xff"};
+    QTest::newRow("64-bit length")
+        << quint64{65536} << false
+        << QByteArray{"\x81\x7f\x00\x00\x00\x00\x00\x01\x00\x00", 10};
+    QTest::newRow("masked")
+        << quint64{5} << true << QByteArray{"\x81\x85\x01\x02\x03\x04"};
+    QTest::newRow("masked, 64-bit length")
+        << quint64{70000} << true
+        << QByteArray{"\x81\xff\x00\x00\x00\x00\x00\x01\x11\x70"
+                      "\x01\x02\x03\x04", 14};
+}
+
+void WebSocketFrameTest::encodeHeader()
+{
+    QFETCH(quint64, payloadSize);
+    QFETCH(bool, masked);
+    QFETCH(QByteArray, header);
+
+    const quint8 key[4] = {1, 2, 3, 4};
+
+    char buffer[MAX_FRAME_HEADER_SIZE];
+    const int size = encodeFrameHeader(buffer, 0x81, payloadSize,
+                                       masked ? key : nullptr);
+
+    QCOMPARE(QByteArray(buffer, size), header);
+}
+
+void WebSocketFrameTest::encodeFrame()
+{
+    QCOMPARE(Tufao::encodeFrame(0x81, "Hello"),
+             QByteArray("\x81\x05Hello"));
+    QCOMPARE(Tufao::encodeFrame(0x82, QByteArray()),
+             QByteArray("\x82\x00", 2));
+
+    const QByteArray payload(300, 'x');
+    QCOMPARE(Tufao::encodeFrame(0xc1, payload),
+             QByteArray("\xc1\x7e\x01\x2c") + payload);
+}
+
+void WebSocketFrameTest::mask_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("split");
+
+    QTest::newRow("empty") << 0 << 0;
+    QTest::newRow("shorter than a word") << 5 << 5;
+    QTest::newRow("one word") << 8 << 8;
+    QTest::newRow("unaligned tail") << 31 << 31;
+    QTest::newRow("split at odd offset") << 100 << 3;
+    QTest::newRow("split after a word") << 100 << 9;
+    QTest::newRow("large, split") << 70001 << 65537;
+}
+
+void WebSocketFrameTest::mask()
+{
+    QFETCH(int, size);
+    QFETCH(int, split);
+
+    const quint8 key[4] = {0x37, 0xfa, 0x21, 0x3d};
+
+    QByteArray payload(size, Qt::Uninitialized);
+    for (int i = 0;i != size;++i)
+        payload[i] = char(i * 7);
+
+    QByteArray expected(payload);
+    for (int i = 0;i != size;++i)
+        expected[i] = expected[i] ^ key[i % 4];
+
+    // The phase must survive the fragment boundary
+    QByteArray masked(payload);
+    quint8 index = 0;
+    maskPayload(masked.data(), split, key, index);
+    QCOMPARE(int(index), split % 4);
+    maskPayload(masked.data() + split, size - split, key, index);
+    QCOMPARE(int(index), size % 4);
+    QCOMPARE(masked, expected);
+
+    // Masking is its own inverse
+    index = 0;
+    maskPayload(masked.data(), masked.size(), key, index);
+    QCOMPARE(masked, payload);
+}
+
+QTEST_APPLESS_MAIN(WebSocketFrameTest)
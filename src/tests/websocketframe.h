@@ -0,0 +1,12 @@
+#include <QtCore/QObject>
+
+class WebSocketFrameTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void encodeHeader_data();
+    void encodeHeader();
+    void encodeFrame();
+    void mask_data();
+    void mask();
+};
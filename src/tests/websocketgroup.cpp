@@ -0,0 +1,216 @@
+#include "websocketgroup.h"
+#include "loopback.h"
+#include <QtTest/QTest>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include "../websocketgroup.h"
+#include "../websocket.h"
+#include "../priv/permessagedeflate.h"
+
+using namespace Tufao;
+
+void WebSocketGroupTest::members()
+{
+    WebSocketGroup group;
+    WebSocket websocket1;
+    WebSocket websocket2;
+    WebSocket *websocket3 = new WebSocket;
+
+    QCOMPARE(group.size(), 0);
+    QVERIFY(!group.add(nullptr));
+
+    QVERIFY(group.add(&websocket1));
+    QVERIFY(!group.add(&websocket1));
+    QVERIFY(group.add(&websocket2));
+    QVERIFY(group.add(websocket3));
+    QCOMPARE(group.size(), 3);
+
+    // The last member takes the place of the removed one
+    QVERIFY(group.remove(&websocket1));
+    QVERIFY(!group.remove(&websocket1));
+    QVERIFY(!group.contains(&websocket1));
+    QVERIFY(group.contains(&websocket2));
+    QVERIFY(group.contains(websocket3));
+    QCOMPARE(group.size(), 2);
+
+    // Destroyed members leave the group
+    delete websocket3;
+    QCOMPARE(group.size(), 1);
+    QVERIFY(group.contains(&websocket2));
+
+    // Members that aren't connected are skipped
+    group.broadcastBinaryMessage("Hello");
+    group.broadcastUtf8Message("Hello");
+
+    group.clear();
+    QCOMPARE(group.size(), 0);
+    QVERIFY(group.add(&websocket2));
+    QVERIFY(group.add(&websocket1));
+    QCOMPARE(group.size(), 2);
+}
+
+void WebSocketGroupTest::properties()
+{
+    WebSocketGroup group;
+
+    QCOMPARE(group.maxPendingBytes(), qint64(1024 * 1024));
+
+    group.setMaxPendingBytes(-1);
+    QCOMPARE(group.maxPendingBytes(), qint64(-1));
+
+    group.setMaxPendingBytes(0);
+    QCOMPARE(group.maxPendingBytes(), qint64(0));
+}
+
+void WebSocketGroupTest::broadcast()
+{
+    LoopbackWebSocket peer1;
+    LoopbackWebSocket peer2;
+    QVERIFY(peer1.open());
+    QVERIFY(peer2.open());
+    WebSocket closed;
+
+    WebSocketGroup group;
+    QVERIFY(group.add(&peer1.websocket));
+    QVERIFY(group.add(&closed));
+    QVERIFY(group.add(&peer2.websocket));
+
+    const QByteArray payload(300, 'b');
+    group.broadcastUtf8Message("Hello");
+    group.broadcastBinaryMessage(payload);
+
+    const QByteArray expected = QByteArray("\x81\x05Hello")
+        + QByteArray("\x82\x7e\x01\x2c") + payload;
+
+    // Every open member gets each frame exactly once
+    for (LoopbackWebSocket *peer: {&peer1, &peer2})
+        QCOMPARE(peer->read(expected.size()), expected);
+
+    QTest::qWait(100);
+    for (LoopbackWebSocket *peer: {&peer1, &peer2}) {
+        QCOMPARE(peer->loopback.client.bytesAvailable(), qint64(0));
+        QVERIFY(peer->received.isEmpty());
+    }
+}
+
+void WebSocketGroupTest::maxPendingBytes()
+{
+    LoopbackWebSocket busy;
+    LoopbackWebSocket idle;
+    QVERIFY(busy.open());
+    QVERIFY(idle.open());
+
+    WebSocketGroup group;
+    group.setMaxPendingBytes(0);
+    QVERIFY(group.add(&busy.websocket));
+    QVERIFY(group.add(&idle.websocket));
+
+    // Nothing is written to the network before the event loop runs
+    QVERIFY(busy.websocket.sendBinaryMessage("busy"));
+    QVERIFY(busy.loopback.request->socket().bytesToWrite() > 0);
+
+    group.broadcastUtf8Message("Hello");
+    QCOMPARE(idle.read(7), QByteArray("\x81\x05Hello"));
+    QCOMPARE(busy.read(6), QByteArray("\x82\x04" "busy"));
+
+    QTest::qWait(100);
+    QCOMPARE(busy.loopback.client.bytesAvailable(), qint64(0));
+    QVERIFY(busy.received.isEmpty());
+
+    // Once its queue is flushed, the member gets the broadcasts again
+    QCOMPARE(busy.loopback.request->socket().bytesToWrite(), qint64(0));
+    group.broadcastUtf8Message("Hello");
+    QCOMPARE(busy.read(7), QByteArray("\x81\x05Hello"));
+    QCOMPARE(idle.read(7), QByteArray("\x81\x05Hello"));
+}
+
+void WebSocketGroupTest::compression()
+{
+    const QByteArray offer("Sec-WebSocket-Extensions: permessage-deflate\r\n");
+
+    LoopbackWebSocket deflate1;
+    LoopbackWebSocket deflate2;
+    LoopbackWebSocket plain;
+    deflate1.websocket.setPermessageDeflate(true);
+    deflate2.websocket.setPermessageDeflate(true);
+    QVERIFY(deflate1.open(offer));
+    QVERIFY(deflate2.open(offer));
+    QVERIFY(plain.open());
+    QVERIFY(deflate1.websocket.isPermessageDeflateActive());
+    QVERIFY(deflate2.websocket.isPermessageDeflateActive());
+    QVERIFY(!plain.websocket.isPermessageDeflateActive());
+
+    WebSocketGroup group;
+    QVERIFY(group.add(&deflate1.websocket));
+    QVERIFY(group.add(&plain.websocket));
+    QVERIFY(group.add(&deflate2.websocket));
+
+    const QByteArray message(1000, 'x');
+    group.broadcastUtf8Message(message);
+
+    // The members that negotiated the extension share the RSV1 frame
+    const QByteArray deflated = PerMessageDeflate::deflate(message);
+    QVERIFY(!deflated.isNull());
+    const QByteArray compressedFrame = encodeFrame(0xc1, deflated);
+    QCOMPARE(deflate1.read(compressedFrame.size()), compressedFrame);
+    QCOMPARE(deflate2.read(compressedFrame.size()), compressedFrame);
+
+    const QByteArray frame = encodeFrame(0x81, message);
+    QCOMPARE(plain.read(frame.size()), frame);
+}
+
+void WebSocketGroupTest::threads()
+{
+    LoopbackWebSocket local;
+    LoopbackWebSocket remote;
+    QVERIFY(local.open());
+    QVERIFY(remote.open());
+
+    // The server side of remote (its WebSocket and socket) is moved to thread
+    QThread thread;
+    thread.start();
+    remote.websocket.moveToThread(&thread);
+    remote.loopback.listener.moveToThread(&thread);
+
+    WebSocketGroup group;
+    QVERIFY(group.add(&local.websocket));
+    QVERIFY(group.add(&remote.websocket));
+
+    // Keeps thread busy, so the broadcast can only be delivered later
+    QSemaphore blocked;
+    QSemaphore gate;
+    QTimer::singleShot(0, &remote.websocket, [&]() {
+        blocked.release();
+        gate.acquire();
+    });
+    blocked.acquire();
+
+    group.broadcastUtf8Message("Hello");
+
+    // The member of the current thread is written before the broadcast
+    // returns, the other is left to its own thread
+    QVERIFY(local.loopback.request->socket().bytesToWrite() > 0);
+    QCOMPARE(local.read(7), QByteArray("\x81\x05Hello"));
+    QTest::qWait(100);
+    QCOMPARE(remote.loopback.client.bytesAvailable(), qint64(0));
+
+    gate.release();
+    QCOMPARE(remote.read(7), QByteArray("\x81\x05Hello"));
+
+    // The objects are moved back before they're destroyed
+    group.clear();
+    QThread *mainThread = QThread::currentThread();
+    QSemaphore moved;
+    QTimer::singleShot(0, &remote.websocket, [&]() {
+        remote.websocket.moveToThread(mainThread);
+        remote.loopback.listener.moveToThread(mainThread);
+        moved.release();
+    });
+    moved.acquire();
+
+    thread.quit();
+    QVERIFY(thread.wait(5000));
+}
+
+QTEST_GUILESS_MAIN(WebSocketGroupTest)
@@ -0,0 +1,13 @@
+#include <QtCore/QObject>
+
+class WebSocketGroupTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void members();
+    void properties();
+    void broadcast();
+    void maxPendingBytes();
+    void compression();
+    void threads();
+};
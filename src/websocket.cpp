@@ -19,6 +19,7 @@
 #include "priv/websocket.h"
 #include "httpserverrequest.h"
 #include "headers.h"
+#include "flatheaders.h"
 
 #include <QtCore/QCryptographicHash>
 #include <QtNetwork/QHostAddress>
@@ -173,7 +174,7 @@ bool WebSocket::startServerHandshake(const HttpServerRequest &request,
                                      const Headers &extraHeaders)
 {
     QAbstractSocket *socket = &request.socket();
-    Headers headers = request.headers();
+    const FlatHeaders &headers = request.flatHeaders();
     if (!hasValueCaseInsensitively(headers.values("Upgrade"), "websocket")) {
         WRITE_STRING(socket->write,
                      "HTTP/1.1 400 Bad Request\r\n"
@@ -183,7 +184,7 @@ bool WebSocket::startServerHandshake(const HttpServerRequest &request,
         return false;
     }
 
-    if (!headers.contains("Sec-WebSocket-Version", "13")) {
+    if (!headers.values("Sec-WebSocket-Version").contains("13")) {
         WRITE_STRING(socket->write,
                      "HTTP/1.1 426 Upgrade Required\r\n"
                      "Connection: keep-alive\r\n"
@@ -207,6 +208,18 @@ bool WebSocket::startServerHandshake(const HttpServerRequest &request,
                  "Connection: Upgrade\r\n"
                  "Upgrade: websocket\r\n");
 
+    // Extensions negotiated through extraHeaders are left to the user
+    if (!extraHeaders.contains("Sec-WebSocket-Extensions")) {
+        QByteArray extensions = priv->deflate.negotiate(headers);
+        if (extensions.size()) {
+            WRITE_STRING(socket->write, "Sec-WebSocket-Extensions: ");
+            socket->write(extensions);
+            socket->write(CRLF);
+        }
+    } else {
+        priv->deflate.reset();
+    }
+
     for (Headers::const_iterator i = extraHeaders.begin()
          ;i != extraHeaders.end();++i) {
         socket->write(i.key());
@@ -250,6 +263,31 @@ WebSocketMessageType WebSocket::messagesType() const
     return priv->messageType;
 }
 
+void WebSocket::setPermessageDeflate(bool enable)
+{
+    priv->deflate.enabled = enable;
+}
+
+bool WebSocket::permessageDeflate() const
+{
+    return priv->deflate.enabled;
+}
+
+void WebSocket::setPermessageDeflateMemoryLimit(int bytes)
+{
+    priv->deflate.memoryLimit = bytes;
+}
+
+int WebSocket::permessageDeflateMemoryLimit() const
+{
+    return priv->deflate.memoryLimit;
+}
+
+bool WebSocket::isPermessageDeflateActive() const
+{
+    return priv->deflate.active;
+}
+
 WebSocketError WebSocket::error() const
 {
     return priv->lastError;
@@ -359,7 +397,13 @@ bool WebSocket::sendBinaryMessage(const QByteArray &msg)
     frame.setFin();
     frame.setOpcode(FrameType::BINARY);
 
-    frame.writePayload(priv->socket, priv->isClientNode, msg);
+    QByteArray compressed;
+    if (priv->deflate.compress(msg, compressed)) {
+        frame.setRsv1();
+        frame.writePayload(priv->socket, priv->isClientNode, compressed);
+    } else {
+        frame.writePayload(priv->socket, priv->isClientNode, msg);
+    }
 
     return true;
 }
@@ -373,7 +417,13 @@ bool WebSocket::sendUtf8Message(const QByteArray &msg)
     frame.setFin();
     frame.setOpcode(FrameType::TEXT);
 
-    frame.writePayload(priv->socket, priv->isClientNode, msg);
+    QByteArray compressed;
+    if (priv->deflate.compress(msg, compressed)) {
+        frame.setRsv1();
+        frame.writePayload(priv->socket, priv->isClientNode, compressed);
+    } else {
+        frame.writePayload(priv->socket, priv->isClientNode, msg);
+    }
 
     return true;
 }
@@ -476,6 +526,12 @@ void WebSocket::onConnected()
         priv->socket->write(i.value());
         priv->socket->write(CRLF);
     }
+    if (priv->deflate.enabled
+        && !priv->clientNode->headers.contains("Sec-WebSocket-Extensions")) {
+        WRITE_STRING(priv->socket->write, "Sec-WebSocket-Extensions: ");
+        priv->socket->write(priv->deflate.offer());
+        priv->socket->write(CRLF);
+    }
     WRITE_STRING(priv->socket->write,
                  "Upgrade: websocket\r\n"
                  "Connection: Upgrade\r\n"
@@ -544,6 +600,7 @@ void WebSocket::connectToHost(QAbstractSocket *socket,
     priv->state = Priv::CONNECTING;
     priv->lastError = WebSocketError::NO_ERROR;
     priv->socket = socket;
+    priv->deflate.reset();
 
     if (!priv->clientNode)
         priv->clientNode = new WebSocketClientNode;
@@ -579,8 +636,10 @@ inline bool WebSocket::isResponseOkay()
                       priv->clientNode->expectedWebSocketAccept))
         return false;
 
-    if (priv->clientNode->response.headers.contains("Sec-WebSocket-Extensions"))
+    if (!priv->deflate.acceptResponse(priv->clientNode->response.headers
+                                      .values("Sec-WebSocket-Extensions"))) {
         return false;
+    }
 
     {
         QList<QByteArray> protocol = priv->clientNode->response.headers
@@ -633,6 +692,18 @@ inline void WebSocket::close(quint16 code)
 
 inline void WebSocket::readData(const QByteArray &data)
 {
+    // Discard the parsed bytes only when it's cheap (nothing to move) or when
+    // they're the majority of the buffer, amortizing the memmove
+    if (priv->bufferOffset) {
+        if (priv->unparsedSize() == 0) {
+            priv->buffer.clear();
+            priv->bufferOffset = 0;
+        } else if (priv->bufferOffset >= priv->unparsedSize()) {
+            priv->buffer.remove(0, priv->bufferOffset);
+            priv->bufferOffset = 0;
+        }
+    }
+
     priv->buffer += data;
     switch (priv->state) {
     case Priv::CONNECTING:
@@ -688,13 +759,13 @@ inline void WebSocket::parseBuffer()
 
 inline bool WebSocket::parseFrame()
 {
-    if (priv->buffer.size() < int(sizeof(Priv::Frame)))
+    if (priv->unparsedSize() < 2)
         return false;
 
     for (uint i = 0;i != 2;++i)
-        priv->frame.bytes[i] = priv->buffer[i];
+        priv->frame.bytes[i] = priv->unparsedData()[i];
 
-    priv->buffer.remove(0, 2);
+    priv->bufferOffset += 2;
 
     if (!priv->frame.fin() && priv->frame.isControlFrame()) {
         close(StatusCode::PROTOCOL_ERROR);
@@ -711,6 +782,21 @@ inline bool WebSocket::parseFrame()
         return false;
     }
 
+    // RSV1 marks compressed messages and is only valid in their first frame
+    if (priv->frame.isDataFrame()
+            && priv->frame.opcode() != FrameType::CONTINUATION) {
+        priv->deflate.compressedMessage = priv->frame.rsv1();
+    }
+
+    if (priv->frame.rsv1()
+            && (!priv->deflate.active || priv->frame.isControlFrame()
+                || priv->frame.opcode() == FrameType::CONTINUATION)) {
+        close(StatusCode::PROTOCOL_ERROR);
+        priv->lastError = WebSocketError::WEBSOCKET_PROTOCOL_ERROR;
+        priv->socket->close();
+        return false;
+    }
+
     if (priv->frame.payloadLength() == 126) {
         priv->parsingState = Priv::PARSING_SIZE_16BIT;
     } else if (priv->frame.payloadLength() == 127) {
@@ -729,17 +815,12 @@ inline bool WebSocket::parseFrame()
 
 inline bool WebSocket::parseSize16()
 {
-    if (priv->buffer.size() < int(sizeof(quint16)))
+    if (priv->unparsedSize() < int(sizeof(quint16)))
         return false;
 
-    uchar size[2];
-
-    for (uint i = 0;i != uint(sizeof(quint16));++i)
-        size[i] = priv->buffer[i];
-
-    priv->buffer.remove(0, sizeof(quint16));
-
-    priv->remainingPayloadSize = qFromBigEndian<quint16>(size);
+    priv->remainingPayloadSize = qFromBigEndian<quint16>
+        (reinterpret_cast<const uchar*>(priv->unparsedData()));
+    priv->bufferOffset += sizeof(quint16);
 
     if (!priv->isClientNode)
         priv->parsingState = Priv::PARSING_MASKING_KEY;
@@ -751,17 +832,12 @@ inline bool WebSocket::parseSize16()
 
 inline bool WebSocket::parseSize64()
 {
-    if (priv->buffer.size() < int(sizeof(quint64)))
+    if (priv->unparsedSize() < int(sizeof(quint64)))
         return false;
 
-    uchar size[8];
-
-    for (uint i = 0;i != uint(sizeof(quint64));++i)
-        size[i] = priv->buffer[i];
-
-    priv->buffer.remove(0, sizeof(quint64));
-
-    priv->remainingPayloadSize = qFromBigEndian<quint64>(size);
+    priv->remainingPayloadSize = qFromBigEndian<quint64>
+        (reinterpret_cast<const uchar*>(priv->unparsedData()));
+    priv->bufferOffset += sizeof(quint64);
 
     if (!priv->isClientNode)
         priv->parsingState = Priv::PARSING_MASKING_KEY;
@@ -773,15 +849,12 @@ inline bool WebSocket::parseSize64()
 
 inline bool WebSocket::parseMaskingKey()
 {
-    if (priv->buffer.size() < int(sizeof(quint32)))
+    if (priv->unparsedSize() < int(sizeof(quint32)))
         return false;
 
     priv->maskingIndex = 0;
-
-    for (int i = 0;i != 4;++i)
-        *(reinterpret_cast<char *>(priv->maskingKey + i)) = priv->buffer[i];
-
-    priv->buffer.remove(0, sizeof(quint32));
+    std::memcpy(priv->maskingKey, priv->unparsedData(), sizeof(quint32));
+    priv->bufferOffset += sizeof(quint32);
 
     priv->parsingState = Priv::PARSING_PAYLOAD_DATA;
 
@@ -800,15 +873,20 @@ inline bool WebSocket::parsePayloadData()
         return true;
     }
 
-    if (!priv->buffer.size())
+    if (!priv->unparsedSize())
         return false;
 
     {
-        QByteArray chunk = priv->buffer.left(priv->remainingPayloadSize);
-        priv->buffer.remove(0, chunk.size());
-        priv->remainingPayloadSize -= chunk.size();
-        decodeFragment(chunk);
-        priv->payload += chunk;
+        // The slice is copied once, straight to the payload, and unmasked
+        // there
+        const int size = int(qMin(quint64(priv->unparsedSize()),
+                                  priv->remainingPayloadSize));
+        const int begin = priv->payload.size();
+
+        priv->payload.append(priv->unparsedData(), size);
+        priv->bufferOffset += size;
+        priv->remainingPayloadSize -= size;
+        decodeFragment(priv->payload.data() + begin, size);
     }
 
     if (priv->remainingPayloadSize)
@@ -821,17 +899,27 @@ inline bool WebSocket::parsePayloadData()
         if (priv->frame.isControlFrame()) {
             evaluateControlFrame();
         } else {
+            QByteArray chunk;
             if (priv->frame.opcode() == FrameType::CONTINUATION) {
                 // CONTINUATION
-                QByteArray chunk(priv->fragment);
+                priv->fragment += priv->payload;
+                chunk = priv->fragment;
                 priv->fragment.clear();
-                emit newMessage(chunk);
             } else {
                 // NON-CONTINUATION
-                QByteArray chunk(priv->payload);
-                priv->payload.clear();
-                emit newMessage(chunk);
+                chunk = priv->payload;
             }
+            priv->payload.clear();
+
+            if (priv->deflate.compressedMessage
+                    && !priv->deflate.inflate(chunk)) {
+                close(StatusCode::INVALID_DATA);
+                priv->lastError = WebSocketError::WEBSOCKET_PROTOCOL_ERROR;
+                priv->socket->close();
+                return false;
+            }
+
+            emit newMessage(chunk);
         }
     } else {
         // NON-FINAL
@@ -845,15 +933,12 @@ inline bool WebSocket::parsePayloadData()
     return true;
 }
 
-inline void WebSocket::decodeFragment(QByteArray &fragment)
+inline void WebSocket::decodeFragment(char *data, int size)
 {
     if (priv->isClientNode)
         return;
 
-    for (int i = 0;i != fragment.size();++i) {
-        fragment[i] = fragment[i] ^ priv->maskingKey[priv->maskingIndex % 4];
-        priv->maskingIndex += 1;
-    }
+    maskPayload(data, size, priv->maskingKey, priv->maskingIndex);
 }
 
 inline void WebSocket::evaluateControlFrame()
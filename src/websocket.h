@@ -434,6 +434,88 @@ public:
       */
     WebSocketMessageType messagesType() const;
 
+    /*!
+      Enables or disables the permessage-deflate extension (RFC 7692) in the
+      next opening handshakes. When the peer agrees, messages are sent
+      compressed (only when compression makes them smaller) and compressed
+      messages from the peer are decompressed before WebSocket::newMessage is
+      emitted.
+
+      Compression trades CPU for bandwidth. It pays off for text protocols
+      such as JSON, but it's a waste on already compressed data.
+
+      The following example enables the extension in the server side:
+
+      \include websocket_permessagedeflate.cpp
+
+      \note
+      The extension is negotiated by Tufao::WebSocket only if the
+      Sec-WebSocket-Extensions header isn't among the extra headers given to
+      the connectToHost or startServerHandshake methods.
+
+      \note
+      The default value is false.
+
+      \sa
+      setPermessageDeflateMemoryLimit
+
+      \since
+      1.5
+     */
+    void setPermessageDeflate(bool enable);
+
+    /*!
+      Returns whether the permessage-deflate extension will be offered (or
+      accepted) in the next opening handshakes.
+
+      \since
+      1.5
+     */
+    bool permessageDeflate() const;
+
+    /*!
+      Sets the maximum number of \p bytes of history kept by the connection to
+      decompress the messages of the peer (the LZ77 window of the peer).
+
+      The peer is asked to use a window that fits in this limit. If no window
+      fits (the minimum is 512 bytes), the peer is asked to compress each
+      message independently, so no history is kept at all.
+
+      \note
+      The messages themselves aren't limited by this value. Decompressed
+      messages bigger than 64MiB are rejected and the connection is closed.
+
+      \note
+      The default value is 32768, the biggest window allowed by the protocol.
+
+      \sa
+      setPermessageDeflate
+
+      \since
+      1.5
+     */
+    void setPermessageDeflateMemoryLimit(int bytes);
+
+    /*!
+      Returns the memory limit used in the permessage-deflate negotiations.
+
+      \sa
+      setPermessageDeflateMemoryLimit
+
+      \since
+      1.5
+     */
+    int permessageDeflateMemoryLimit() const;
+
+    /*!
+      Returns true if the permessage-deflate extension was negotiated in the
+      last opening handshake.
+
+      \since
+      1.5
+     */
+    bool isPermessageDeflateActive() const;
+
     /*!
       Returns the type of last error that occurred.
       */
@@ -541,9 +623,12 @@ private:
     bool parseMaskingKey();
     bool parsePayloadData();
 
-    void decodeFragment(QByteArray &fragment);
+    void decodeFragment(char *data, int size);
     void evaluateControlFrame();
 
+    // Writes shared frames directly to the socket
+    friend class WebSocketGroup;
+
     struct Priv;
     Priv *priv;
 };
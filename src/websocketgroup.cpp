@@ -0,0 +1,280 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "priv/websocketgroup.h"
+#include "priv/websocket.h"
+
+#include <QtCore/QThread>
+
+namespace Tufao {
+
+WebSocketGroup::WebSocketGroup(QObject *parent) :
+    QObject(parent),
+    priv(new Priv)
+{
+}
+
+WebSocketGroup::~WebSocketGroup()
+{
+    clear();
+    delete priv;
+}
+
+bool WebSocketGroup::add(WebSocket *websocket)
+{
+    if (!websocket || priv->locations.contains(websocket))
+        return false;
+
+    QThread *thread = websocket->thread();
+    Priv::Members &members = priv->shards[thread].members;
+
+    Priv::Location location = {thread, members.size()};
+    priv->locations.insert(websocket, location);
+
+    Priv::Member member = {websocket, websocket};
+    members.push_back(member);
+
+    // Former members may be still connected (see clear)
+    connect(websocket, &AbstractMessageSocket::disconnected,
+            this, &WebSocketGroup::onMemberDisconnected,
+            Qt::UniqueConnection);
+    connect(websocket, &QObject::destroyed,
+            this, &WebSocketGroup::onMemberDestroyed, Qt::UniqueConnection);
+
+    return true;
+}
+
+bool WebSocketGroup::remove(WebSocket *websocket)
+{
+    if (!priv->remove(websocket))
+        return false;
+
+    disconnect(websocket, 0, this, 0);
+    return true;
+}
+
+bool WebSocketGroup::contains(WebSocket *websocket) const
+{
+    return priv->locations.contains(websocket);
+}
+
+int WebSocketGroup::size() const
+{
+    return priv->locations.size();
+}
+
+void WebSocketGroup::clear()
+{
+    // The members aren't disconnected from the group, as the members of other
+    // threads may be being destroyed. Signals from non-members are ignored.
+    for (QHash<QThread*, Priv::Shard>::iterator i = priv->shards.begin()
+         ;i != priv->shards.end();++i) {
+        if (i->worker)
+            i->worker->deleteLater();
+    }
+
+    priv->shards.clear();
+    priv->locations.clear();
+}
+
+void WebSocketGroup::setMaxPendingBytes(qint64 bytes)
+{
+    priv->maxPendingBytes = bytes;
+}
+
+qint64 WebSocketGroup::maxPendingBytes() const
+{
+    return priv->maxPendingBytes;
+}
+
+void WebSocketGroup::broadcastBinaryMessage(const QByteArray &msg)
+{
+    priv->broadcast(FrameType::BINARY, msg);
+}
+
+void WebSocketGroup::broadcastUtf8Message(const QByteArray &msg)
+{
+    priv->broadcast(FrameType::TEXT, msg);
+}
+
+void WebSocketGroup::onMemberDisconnected()
+{
+    // The signal may be queued, so the member is only used as a key
+    priv->remove(sender());
+}
+
+void WebSocketGroup::onMemberDestroyed(QObject *member)
+{
+    priv->remove(member);
+}
+
+bool WebSocketGroup::Priv::remove(QObject *key)
+{
+    QHash<QObject*, Location>::iterator i = locations.find(key);
+    if (i == locations.end())
+        return false;
+
+    const Location location = *i;
+    locations.erase(i);
+
+    // The last member takes the place of the removed one
+    Shard &shard = shards[location.thread];
+    if (location.index != shard.members.size() - 1) {
+        shard.members[location.index] = shard.members.last();
+        locations[shard.members[location.index].key].index = location.index;
+    }
+    shard.members.removeLast();
+
+    if (shard.members.isEmpty()) {
+        if (shard.worker)
+            shard.worker->deleteLater();
+
+        shards.remove(location.thread);
+    }
+
+    return true;
+}
+
+void WebSocketGroup::Priv::broadcast(quint8 opcode, const QByteArray &payload)
+{
+    if (shards.isEmpty())
+        return;
+
+    // Frames of server nodes aren't masked, so they're the same for everyone
+    WebSocket::Priv::Frame header
+        = WebSocket::Priv::Frame::standardFrame(false);
+    header.setFin();
+    header.setOpcode(opcode);
+    const QByteArray frame = encodeFrame(quint8(header.bytes[0]), payload);
+
+    const qint64 maxPendingBytes = this->maxPendingBytes;
+    QThread *currentThread = QThread::currentThread();
+
+    // Delivering to the current thread can change the shards
+    foreach (QThread *thread, shards.keys()) {
+        QHash<QThread*, Shard>::iterator shard = shards.find(thread);
+        if (shard == shards.end())
+            continue;
+
+        // The QVector is implicitly shared, so this copy is cheap
+        const Members members = shard->members;
+
+        if (thread == currentThread) {
+            deliver(members, opcode, payload, frame, maxPendingBytes);
+            continue;
+        }
+
+        if (!shard->worker) {
+            shard->worker = new WebSocketGroupWorker;
+            shard->worker->moveToThread(thread);
+        }
+
+        shard->worker->post([members, opcode, payload, frame,
+                             maxPendingBytes]() {
+            deliver(members, opcode, payload, frame, maxPendingBytes);
+        });
+    }
+}
+
+void WebSocketGroup::Priv::deliver(Members members, quint8 opcode,
+                                   const QByteArray &payload,
+                                   const QByteArray &frame,
+                                   qint64 maxPendingBytes)
+{
+    // Built on demand, when the first member that negotiated
+    // permessage-deflate is found
+    QByteArray compressedFrame;
+    bool compressed = false;
+
+    for (int i = 0;i != members.size();++i) {
+        WebSocket *websocket = members.at(i).websocket.data();
+        if (!websocket)
+            continue;
+
+        // Moved to another thread after it was added (see add)
+        if (websocket->thread() != QThread::currentThread())
+            continue;
+
+        WebSocket::Priv *member = websocket->priv;
+        if (member->state != WebSocket::Priv::OPEN)
+            continue;
+
+        if (maxPendingBytes >= 0
+            && member->socket->bytesToWrite() > maxPendingBytes) {
+            continue;
+        }
+
+        // Each frame of a client node is masked with a different key
+        if (member->isClientNode) {
+            if (opcode == FrameType::TEXT)
+                websocket->sendUtf8Message(payload);
+            else
+                websocket->sendBinaryMessage(payload);
+
+            continue;
+        }
+
+        if (member->deflate.accepts(payload.size())) {
+            if (!compressed) {
+                compressed = true;
+
+                QByteArray deflated = PerMessageDeflate::deflate(payload);
+                if (!deflated.isNull()) {
+                    WebSocket::Priv::Frame header
+                        = WebSocket::Priv::Frame::standardFrame(false);
+                    header.setFin();
+                    header.setRsv1();
+                    header.setOpcode(opcode);
+                    compressedFrame = encodeFrame(quint8(header.bytes[0]),
+                                                  deflated);
+                }
+            }
+
+            if (!compressedFrame.isNull()) {
+                member->socket->write(compressedFrame);
+                continue;
+            }
+        }
+
+        member->socket->write(frame);
+    }
+}
+
+void WebSocketGroupWorker::post(std::function<void()> job)
+{
+    QMutexLocker locker(&mutex);
+    jobs.push_back(std::move(job));
+
+    // A single run takes all the jobs posted until then
+    if (jobs.size() == 1)
+        QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection);
+}
+
+void WebSocketGroupWorker::run()
+{
+    QVector<std::function<void()>> pending;
+    {
+        QMutexLocker locker(&mutex);
+        pending.swap(jobs);
+    }
+
+    for (int i = 0;i != pending.size();++i)
+        pending[i]();
+}
+
+} // namespace Tufao
@@ -0,0 +1,162 @@
+/*  This file is part of the Tufão project
+    Copyright (C) 2016 Vinícius dos Santos Oliveira <vini.ipsmaker@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any
+    later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUFAO_WEBSOCKETGROUP_H
+#define TUFAO_WEBSOCKETGROUP_H
+
+#include <QtCore/QObject>
+
+#include "tufao_global.h"
+
+namespace Tufao {
+
+class WebSocket;
+
+/*!
+  This class sends the same messages to a group of WebSocket connections, such
+  as the subscribers of a channel.
+
+  Each message is encoded into a frame only once and the same implicitly shared
+  buffer is written to every member, so the cost of a broadcast is dominated by
+  the socket writes, not by the frame building. Members that negotiated the
+  permessage-deflate extension share a single compressed frame too (per
+  thread). Only members acting as clients get their own frames, as each of
+  their frames must be masked with a different key.
+
+  Members whose outbound queue (the bytes still waiting to be written to the
+  network) is bigger than maxPendingBytes are skipped, so a slow consumer
+  doesn't make the server buffer an unbounded amount of messages for it.
+
+  Members may live in different threads, like the connections served by the
+  worker threads of HttpServer. The members living in other threads are
+  written from their own threads, in parallel, after the broadcast method
+  returns. The members living in the thread of the caller are written before
+  the broadcast method returns.
+
+  Members are removed from the group when they're disconnected or destroyed.
+
+  \include websocketgroup.cpp
+
+  \note
+  The group itself isn't thread-safe. Its methods should be called from the
+  thread the group lives in.
+
+  \since
+  1.5
+  */
+class TUFAO_EXPORT WebSocketGroup : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+      Constructs an empty Tufao::WebSocketGroup object.
+
+      \p parent is passed to the QObject constructor.
+      */
+    explicit WebSocketGroup(QObject *parent = 0);
+
+    /*!
+      Destroys the object.
+
+      The members aren't affected.
+      */
+    ~WebSocketGroup();
+
+    /*!
+      Adds \p websocket to the group.
+
+      The member is written from the thread it lives in when it's added.
+
+      \note
+      Don't move a member to another thread (QObject::moveToThread). Remove it
+      from the group before the move and add it again afterwards. A member
+      moved while in the group is skipped by the broadcasts.
+
+      \retval false if \p websocket is null or already a member.
+      */
+    bool add(WebSocket *websocket);
+
+    /*!
+      Removes \p websocket from the group.
+
+      \retval false if \p websocket isn't a member.
+      */
+    bool remove(WebSocket *websocket);
+
+    /*!
+      Returns true if \p websocket is a member of the group.
+      */
+    bool contains(WebSocket *websocket) const;
+
+    /*!
+      Returns the number of members.
+      */
+    int size() const;
+
+    /*!
+      Removes all members.
+      */
+    void clear();
+
+    /*!
+      Sets the maximum number of \p bytes that may be waiting to be written in
+      the connection of a member for it to receive new messages. The messages
+      broadcasted while the limit is exceeded are dropped for that member.
+
+      A negative value disables the limit. The default value is 1MiB.
+      */
+    void setMaxPendingBytes(qint64 bytes);
+
+    /*!
+      Returns the maximum number of bytes that may be waiting to be written in
+      the connection of a member for it to receive new messages.
+
+      \sa
+      setMaxPendingBytes
+      */
+    qint64 maxPendingBytes() const;
+
+public slots:
+    /*!
+      Sends a binary message to every open member.
+
+      \sa
+      WebSocket::sendBinaryMessage
+      */
+    void broadcastBinaryMessage(const QByteArray &msg);
+
+    /*!
+      Sends a UTF-8 text message to every open member.
+
+      \sa
+      WebSocket::sendUtf8Message
+      */
+    void broadcastUtf8Message(const QByteArray &msg);
+
+private slots:
+    void onMemberDisconnected();
+    void onMemberDestroyed(QObject *member);
+
+private:
+    struct Priv;
+    Priv *priv;
+};
+
+} // namespace Tufao
+
+#endif // TUFAO_WEBSOCKETGROUP_H